@@ -0,0 +1,270 @@
+#include "baseline.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+
+#include "eqclass.hpp"
+#include "eqclassmgr.hpp"
+#include "fib.hpp"
+#include "fibmgr.hpp"
+#include "interface.hpp"
+#include "link.hpp"
+#include "logger.hpp"
+#include "middlebox.hpp"
+#include "network.hpp"
+#include "node.hpp"
+#include "process/openflow.hpp"
+#include "route.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+Baseline::Baseline() : _loaded(false), _topology_changed(false) {}
+
+static string route_str(const Route &route) {
+    return route.get_network().to_string() + " " +
+           route.get_next_hop().to_string() + " " + route.get_intf() + " " +
+           to_string(route.get_adm_dist());
+}
+
+/**
+ * Returns the lines of the snapshot of the network and the openflow updates:
+ *   T node <node> <interfaces>
+ *   T link <link>
+ *   R <node> <prefix> <next hop> <interface> <administrative distance>
+ *   U <node> <update index> <prefix> <next hop> <interface> <adm. distance>
+ *   M <middlebox> <config digest>
+ */
+set<string> Baseline::snapshot(const Network &network,
+                               const OpenflowProcess &openflow) {
+    set<string> lines;
+
+    for (const auto &[name, node] : network.nodes()) {
+        string line = "T node " + name;
+        for (const auto &[intf_name, intf] : node->get_intfs()) {
+            line += " " + intf_name + " ";
+            if (intf->is_l2()) {
+                line += "l2";
+            } else {
+                line += intf->addr().to_string() + "/" +
+                        to_string(intf->prefix_length());
+            }
+        }
+        lines.insert(line);
+
+        for (const Route &route : node->get_rib()) {
+            lines.insert("R " + name + " " + route_str(route));
+        }
+    }
+
+    for (Link *link : network.links()) {
+        lines.insert("T link " + link->to_string());
+    }
+
+    for (const auto &[node, updates] : openflow.get_updates()) {
+        for (size_t i = 0; i < updates.size(); ++i) {
+            lines.insert("U " + node->get_name() + " " + to_string(i) + " " +
+                         route_str(updates[i]));
+        }
+    }
+
+    for (Middlebox *mb : network.middleboxes()) {
+        lines.insert("M " + mb->get_name() + " " +
+                     to_string(mb->config_digest()));
+    }
+
+    return lines;
+}
+
+void Baseline::write_snapshot(const fs::path &out_dir,
+                              const Network &network,
+                              const OpenflowProcess &openflow) {
+    const fs::path path = out_dir / "dataplane";
+    ofstream ofs(path);
+    if (!ofs) {
+        logger.error("Failed to open " + path.string());
+    }
+    for (const string &line : snapshot(network, openflow)) {
+        ofs << line << endl;
+    }
+}
+
+/**
+ * Loads the snapshot and the journal of the baseline run, and diffs the
+ * snapshot against the current network.
+ */
+void Baseline::load(const fs::path &baseline_dir,
+                    const Network &network,
+                    const OpenflowProcess &openflow) {
+    reset();
+
+    const fs::path path = baseline_dir / "dataplane";
+    ifstream ifs(path);
+    if (!ifs) {
+        logger.error("Failed to open " + path.string());
+    }
+
+    set<string> old_lines;
+    string line;
+    while (getline(ifs, line)) {
+        old_lines.insert(line);
+    }
+    const set<string> new_lines = snapshot(network, openflow);
+
+    vector<string> diff;
+    set_symmetric_difference(old_lines.begin(), old_lines.end(),
+                             new_lines.begin(), new_lines.end(),
+                             back_inserter(diff));
+
+    for (const string &l : diff) {
+        istringstream iss(l);
+        string type, name, field;
+        iss >> type >> name;
+
+        if (type == "T") {
+            _topology_changed = true;
+        } else if (type == "R" || type == "U") {
+            if (type == "U") {
+                iss >> field; // update index
+            }
+            iss >> field;
+            _changed_prefixes.emplace_back(field);
+        } else if (type == "M") {
+            auto it = network.nodes().find(name);
+            if (it != network.nodes().end()) {
+                _changed_mbs.insert(it->second);
+            }
+        }
+    }
+
+    for (const auto &[_, inv] : Journal::read(baseline_dir / "journal")) {
+        for (const auto &[_, res] : inv.results) {
+            if (!res.conns.empty()) {
+                _results.emplace(make_pair(inv.inv, res.conns), res);
+            }
+        }
+    }
+
+    _loaded = true;
+    logger.info("Baseline " + baseline_dir.string() + ": " +
+                (_topology_changed ? "topology changed, "s : ""s) +
+                to_string(_changed_prefixes.size()) + " changed routes, " +
+                to_string(_changed_mbs.size()) + " changed middleboxes, " +
+                to_string(_results.size()) + " results");
+}
+
+void Baseline::reset() {
+    _loaded = false;
+    _topology_changed = false;
+    _changed_prefixes.clear();
+    _changed_mbs.clear();
+    _results.clear();
+}
+
+/**
+ * Returns true if any range of the EC overlaps with a changed prefix. Note that
+ * the ranges are checked rather than whether the routes are relevant to the EC,
+ * since a removed route may have split the ECs differently.
+ */
+bool Baseline::affected(EqClass *ec) const {
+    for (const ECRange &range : *ec) {
+        for (const auto &prefix : _changed_prefixes) {
+            if (ECRange(prefix) == range) { // overlap
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if any changed middlebox is reachable from the source node along
+ * the FIBs of the destination EC, or from any of the reached nodes along the
+ * FIBs of the source IP ECs (replies). Unknown FIBs count as reachable.
+ */
+bool Baseline::reaches_changed_mb(Node *src_node,
+                                  EqClass *dst_ip_ec,
+                                  const set<EqClass *> &src_ip_ecs) const {
+    FIBMgr &fib_mgr = FIBMgr::get();
+    unordered_set<Node *> reached{src_node};
+    deque<pair<Node *, EqClass *>> queue{{src_node, dst_ip_ec}};
+    set<pair<Node *, EqClass *>> visited{{src_node, dst_ip_ec}};
+
+    while (!queue.empty()) {
+        const auto [node, ec] = queue.front();
+        queue.pop_front();
+
+        const auto all_ipnhs = fib_mgr.get_all_ipnhs(ec, node);
+        if (all_ipnhs.empty()) {
+            return true;
+        }
+
+        for (const auto &next_hops : all_ipnhs) {
+            for (const FIB_IPNH &next_hop : next_hops) {
+                for (Node *nh : {next_hop.l2_node(), next_hop.l3_node()}) {
+                    if (_changed_mbs.count(nh) > 0) {
+                        return true;
+                    }
+                    if (reached.insert(nh).second) {
+                        for (EqClass *src_ip_ec : src_ip_ecs) {
+                            if (visited.emplace(nh, src_ip_ec).second) {
+                                queue.emplace_back(nh, src_ip_ec);
+                            }
+                        }
+                    }
+                    if (visited.emplace(nh, ec).second) {
+                        queue.emplace_back(nh, ec);
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Returns true if the verification result of the connections may differ from
+ * that of the baseline run.
+ */
+bool Baseline::affected(const vector<Connection> &conns) const {
+    if (_topology_changed) {
+        return true;
+    }
+
+    for (const Connection &conn : conns) {
+        if (_changed_mbs.count(conn.get_src_node()) > 0 ||
+            affected(conn.get_dst_ip_ec())) {
+            return true;
+        }
+
+        set<EqClass *> src_ip_ecs;
+        for (const auto &[addr, _] : conn.get_src_node()->get_intfs_l3()) {
+            EqClass *src_ip_ec = EqClassMgr::get().find_ec(addr);
+            if (src_ip_ec) {
+                if (affected(src_ip_ec)) {
+                    return true;
+                }
+                src_ip_ecs.insert(src_ip_ec);
+            }
+        }
+
+        if (!_changed_mbs.empty() &&
+            reaches_changed_mb(conn.get_src_node(), conn.get_dst_ip_ec(),
+                               src_ip_ecs)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const Journal::Result *Baseline::result(const string &inv,
+                                        const string &conns) const {
+    auto it = _results.find(make_pair(inv, conns));
+    return it == _results.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "conn.hpp"
+#include "journal.hpp"
+#include "lib/ip.hpp"
+
+class EqClass;
+class Network;
+class Node;
+class OpenflowProcess;
+
+/**
+ * Baseline finds the connection ECs whose verification results can be carried
+ * over from a previous run (`--baseline <previous output dir>`).
+ *
+ * Every run writes a snapshot of its parsed network and openflow updates into
+ * the output directory (`dataplane`). The snapshot of the baseline run is
+ * diffed against the current one:
+ *  - a change in the topology (nodes, interfaces, links) affects all ECs,
+ *  - a changed static route or openflow update affects the ECs overlapping its
+ *    prefix, and
+ *  - a changed middlebox (image, configs, etc.) affects the ECs whose packets
+ *    may traverse it.
+ * A connection EC is unaffected if none of the destination ECs and the source
+ * IP ECs of its connections is affected, and none of the changed middleboxes is
+ * reachable along their FIBs. The results of the unaffected ECs are carried
+ * over from the baseline journal, matched by the invariant and the connections.
+ * Like partial-order reduction, this assumes that middleboxes do not redirect
+ * packets off the FIB paths of the connection.
+ */
+class Baseline {
+private:
+    bool _loaded;
+    bool _topology_changed;
+    std::vector<IPNetwork<IPv4Address>> _changed_prefixes;
+    std::set<Node *> _changed_mbs;
+    // (invariant, connections) -> result
+    std::map<std::pair<std::string, std::string>, Journal::Result> _results;
+
+    static std::set<std::string> snapshot(const Network &,
+                                          const OpenflowProcess &);
+    bool affected(EqClass *) const;
+    bool reaches_changed_mb(Node *src_node,
+                            EqClass *dst_ip_ec,
+                            const std::set<EqClass *> &src_ip_ecs) const;
+
+public:
+    Baseline();
+
+    static void write_snapshot(const std::filesystem::path &out_dir,
+                               const Network &,
+                               const OpenflowProcess &);
+    void load(const std::filesystem::path &baseline_dir,
+              const Network &,
+              const OpenflowProcess &);
+    void reset();
+
+    bool loaded() const { return _loaded; }
+    bool affected(const std::vector<Connection> &) const;
+    const Journal::Result *result(const std::string &inv,
+                                  const std::string &conns) const;
+};
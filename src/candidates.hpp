@@ -4,8 +4,9 @@
 #include <vector>
 
 #include "fib.hpp"
+#include "lib/idmap.hpp"
 
-class Candidates {
+class Candidates : public DenseID {
 private:
     std::vector<FIB_IPNH> next_hops;
 
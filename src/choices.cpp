@@ -6,36 +6,36 @@
 #include "logger.hpp"
 #include "node.hpp"
 
+size_t Choices::KeyHash::operator()(const Key &key) const {
+    size_t value = std::hash<EqClass *>()(key.first);
+    hash::hash_combine(value, std::hash<Node *>()(key.second));
+    return value;
+}
+
 void Choices::add_choice(EqClass *ec, Node *node, const FIB_IPNH &choice) {
-    auto res = tbl.emplace(std::make_pair(ec, node), choice);
-    if (!res.second) {
+    if (!tbl.assign(std::make_pair(ec, node), choice)) {
         logger.error("Duplicate choice key: (" + ec->to_string() + ", " +
                      node->to_string() + ")");
     }
+
+    size_t value = KeyHash()(std::make_pair(ec, node));
+    hash::hash_combine(value, FIB_IPNH_Hash()(choice));
+    _hash += hash::mix(value);
 }
 
 std::optional<FIB_IPNH> Choices::get_choice(EqClass *ec, Node *node) const {
-    auto it = tbl.find(std::make_pair(ec, node));
-    if (it == tbl.end()) {
+    const FIB_IPNH *choice = tbl.find(std::make_pair(ec, node));
+    if (!choice) {
         return std::optional<FIB_IPNH>();
     }
-    return std::optional<FIB_IPNH>(it->second);
+    return std::optional<FIB_IPNH>(*choice);
 }
 
 size_t ChoicesHash::operator()(const Choices *const &choices) const {
-    size_t value = 0;
-    std::hash<EqClass *> ec_hf;
-    std::hash<Node *> node_hf;
-    FIB_IPNH_Hash ipnh_hf;
-    for (const auto &entry : choices->tbl) {
-        hash::hash_combine(value, ec_hf(entry.first.first));
-        hash::hash_combine(value, node_hf(entry.first.second));
-        hash::hash_combine(value, ipnh_hf(entry.second));
-    }
-    return value;
+    return choices->_hash;
 }
 
 bool ChoicesEq::operator()(const Choices *const &a,
                            const Choices *const &b) const {
-    return a->tbl == b->tbl;
+    return a->_hash == b->_hash && a->tbl == b->tbl;
 }
@@ -1,15 +1,29 @@
 #pragma once
 
-#include <map>
+#include <cstddef>
 #include <optional>
+#include <utility>
+
+#include "fib.hpp"
+#include "lib/idmap.hpp"
+#include "lib/persistent-map.hpp"
 
 class EqClass;
 class Node;
-class FIB_IPNH;
 
-class Choices {
+/**
+ * Choices are the past path choices of multipath forwarding, in a persistent
+ * map, so that adding a choice does not copy the others.
+ */
+class Choices : public DenseID {
 private:
-    std::map<std::pair<EqClass *, Node *>, FIB_IPNH> tbl;
+    using Key = std::pair<EqClass *, Node *>;
+    struct KeyHash {
+        size_t operator()(const Key &) const;
+    };
+
+    PersistentMap<Key, FIB_IPNH, KeyHash> tbl;
+    size_t _hash = 0; // sum of the mixed hashes of the entries
 
     friend class ChoicesHash;
     friend class ChoicesEq;
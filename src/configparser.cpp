@@ -1,10 +1,13 @@
 #include "configparser.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <regex>
 #include <sstream>
+#include <vector>
 
 #include <toml++/toml.h>
 
@@ -24,6 +27,7 @@
 #include "invariant/reachability.hpp"
 #include "invariant/reply-reachability.hpp"
 #include "invariant/waypoint.hpp"
+#include "lib/hash.hpp"
 #include "link.hpp"
 #include "logger.hpp"
 #include "middlebox.hpp"
@@ -374,6 +378,7 @@ void ConfigParser::parse_dockernode(DockerNode &dn, const toml::table &config) {
     }
 
     // Search for config file locations and parse for IP and ports
+    string cfg_contents;
     if (cfg_files) {
         Docker docker(&dn, /* log_pkts */ false);
         docker.init();
@@ -396,6 +401,7 @@ void ConfigParser::parse_dockernode(DockerNode &dn, const toml::table &config) {
             buffer << ifs.rdbuf();
             const string config = buffer.str();
             this->parse_config_string(dn, config);
+            cfg_contents += filename + '\0' + config + '\0';
         }
 
         docker.leavens(/* mnt */ true);
@@ -413,6 +419,52 @@ void ConfigParser::parse_dockernode(DockerNode &dn, const toml::table &config) {
     for (const auto &[_, value] : dn.env_vars()) {
         this->parse_config_string(dn, value);
     }
+
+    // Fingerprint everything that determines the middlebox behavior, which is
+    // used for identifying the persistent injection results across runs.
+    string identity;
+    auto &img_id = img_json["data"]["Id"];
+    identity += (img_id.IsString() ? img_id.GetString() : dn.image()) + '\0';
+    identity += dn.working_dir() + '\0' + (dn.dpdk() ? "1" : "0") + '\0';
+    for (const string &arg : dn.cmd()) {
+        identity += arg + '\0';
+    }
+    for (const auto &[protocol, port] : dn.ports()) {
+        identity += to_string(int(protocol)) + '/' + to_string(port) + '\0';
+    }
+    for (const auto &[name, value] : map(dn.env_vars().begin(),
+                                         dn.env_vars().end())) {
+        identity += name + '=' + value + '\0';
+    }
+    for (const auto &mnt : dn.mounts()) {
+        identity += mnt.host_path + ':' + mnt.mount_path + ':' + mnt.driver +
+                    (mnt.read_only ? ":ro" : "") + '\0';
+    }
+    for (const auto &[key, value] : map(dn.sysctls().begin(),
+                                        dn.sysctls().end())) {
+        identity += key + '=' + value + '\0';
+    }
+    vector<string> routes; // installed into the container by set_rttable
+    for (const Route &route : dn.get_rib()) {
+        routes.push_back(route.get_network().to_string() + ' ' +
+                         route.get_next_hop().to_string() + ' ' +
+                         route.get_intf() + ' ' +
+                         to_string(route.get_adm_dist()));
+    }
+    sort(routes.begin(), routes.end());
+    for (const string &route : routes) {
+        identity += route + '\0';
+    }
+    for (const auto &[name, intf] : dn.get_intfs()) {
+        identity += name;
+        if (!intf->is_l2()) {
+            identity += ' ' + intf->addr().to_string() + '/' +
+                        to_string(intf->prefix_length());
+        }
+        identity += '\0';
+    }
+    identity += to_string(dn.packets_per_injection()) + '\0' + cfg_contents;
+    dn._config_digest = ::hash::hash(identity.data(), identity.size());
 }
 
 void ConfigParser::parse_middlebox(Middlebox &middlebox,
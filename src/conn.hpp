@@ -35,6 +35,12 @@ public:
     Connection(const Connection &) = default;
     Connection(Connection &&) = default;
 
+    int get_protocol() const { return protocol; }
+    Node *get_src_node() const { return src_node; }
+    EqClass *get_dst_ip_ec() const { return dst_ip_ec; }
+    uint16_t get_src_port() const { return src_port; }
+    uint16_t get_dst_port() const { return dst_port; }
+
     std::string to_string() const;
     void init(size_t conn_idx) const;
 };
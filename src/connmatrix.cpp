@@ -1,55 +1,263 @@
 #include "connmatrix.hpp"
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <tuple>
+
+#include "eqclass.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+
 using namespace std;
 
-size_t ConnectionMatrix::num_conns() const {
+// Orders the connections independently of the object addresses
+bool ConnectionSet::stable_less(const Connection &a, const Connection &b) {
+    return make_tuple(a.get_protocol(), a.get_src_node()->get_name(),
+                      a.get_dst_ip_ec()->representative_addr(),
+                      a.get_src_port(), a.get_dst_port()) <
+           make_tuple(b.get_protocol(), b.get_src_node()->get_name(),
+                      b.get_dst_ip_ec()->representative_addr(),
+                      b.get_src_port(), b.get_dst_port());
+}
+
+ConnectionSet::ConnectionSet(set<Connection> &&conns) :
+    is_explicit(true),
+    protocol(0),
+    src_port(0) {
+    // Connections aren't assignable, so their pointers are sorted instead
+    vector<const Connection *> sorted;
+    for (const Connection &conn : conns) {
+        sorted.push_back(&conn);
+    }
+    sort(sorted.begin(), sorted.end(),
+         [](const Connection *a, const Connection *b) {
+             return stable_less(*a, *b);
+         });
+    this->conns.reserve(sorted.size());
+    for (const Connection *conn : sorted) {
+        this->conns.push_back(*conn);
+    }
+}
+
+/**
+ * Constructs the connection set of the representatives of symmetric
+ * connections, where each group is led by its representative.
+ */
+ConnectionSet::ConnectionSet(vector<vector<Connection>> &&groups) :
+    is_explicit(true),
+    protocol(0),
+    src_port(0) {
+    sort(groups.begin(), groups.end(),
+         [](const vector<Connection> &a, const vector<Connection> &b) {
+             return stable_less(a.front(), b.front());
+         });
+    this->conns.reserve(groups.size());
+    for (const vector<Connection> &group : groups) {
+        this->conns.push_back(group.front());
+    }
+    this->groups = std::move(groups);
+}
+
+ConnectionSet::ConnectionSet(int protocol,
+                             const set<Node *> &src_nodes,
+                             const set<EqClass *> &dst_ip_ecs,
+                             uint16_t src_port,
+                             const set<uint16_t> &dst_ports) :
+    is_explicit(false),
+    protocol(protocol),
+    src_port(src_port),
+    src_nodes(src_nodes.begin(), src_nodes.end()),
+    dst_ip_ecs(dst_ip_ecs.begin(), dst_ip_ecs.end()),
+    dst_ports(dst_ports.begin(), dst_ports.end()) {
+    // The ECs are disjoint, so their lowest addresses are distinct
+    sort(this->src_nodes.begin(), this->src_nodes.end(),
+         [](Node *a, Node *b) { return a->get_name() < b->get_name(); });
+    sort(this->dst_ip_ecs.begin(), this->dst_ip_ecs.end(),
+         [](EqClass *a, EqClass *b) {
+             return a->representative_addr() < b->representative_addr();
+         });
+}
+
+size_t ConnectionSet::size() const {
+    if (is_explicit) {
+        return conns.size();
+    }
+    return src_nodes.size() * dst_ip_ecs.size() * dst_ports.size();
+}
+
+Connection ConnectionSet::at(size_t idx) const {
+    if (idx >= size()) {
+        logger.error("Connection index out of range: " + to_string(idx));
+    }
+
+    if (is_explicit) {
+        return conns[idx];
+    }
+
+    // src node (most significant), dst IP EC, dst port (least significant)
+    const uint16_t dst_port = dst_ports[idx % dst_ports.size()];
+    idx /= dst_ports.size();
+    EqClass *dst_ip_ec = dst_ip_ecs[idx % dst_ip_ecs.size()];
+    idx /= dst_ip_ecs.size();
+    return Connection(protocol, src_nodes[idx], dst_ip_ec, src_port, dst_port);
+}
+
+vector<Connection> ConnectionSet::members(size_t idx) const {
+    if (groups.empty()) {
+        return {at(idx)};
+    } else if (idx >= groups.size()) {
+        logger.error("Connection index out of range: " + to_string(idx));
+    }
+    return groups[idx];
+}
+
+size_t ConnectionMatrix::size() const {
     size_t num = 1;
-    for (const auto &conn_set : product) {
-        num *= conn_set.size();
+    for (const auto &conns : product) {
+        num *= conns.size();
     }
     return num;
 }
 
+vector<size_t> ConnectionMatrix::dim_sizes() const {
+    vector<size_t> sizes;
+    for (const auto &dim : product) {
+        sizes.push_back(dim.size());
+    }
+    return sizes;
+}
+
 void ConnectionMatrix::clear() {
     product.clear();
-    itrs.clear();
-    traversed_all = false;
+    next_idx = 0;
 }
 
 void ConnectionMatrix::reset() {
-    for (size_t i = 0; i < product.size(); ++i) {
-        itrs[i] = product[i].begin();
-    }
-    traversed_all = false;
+    next_idx = 0;
 }
 
-void ConnectionMatrix::add(set<Connection> &&conns) {
+void ConnectionMatrix::add(ConnectionSet &&conns) {
     product.push_back(std::move(conns));
-    itrs.push_back(product.back().begin());
 }
 
 vector<Connection> ConnectionMatrix::get_next_conns() {
+    if (next_idx >= size()) {
+        return {};
+    }
+    return at(next_idx++);
+}
+
+vector<Connection> ConnectionMatrix::at(size_t idx) const {
     vector<Connection> conns;
 
-    if (traversed_all) {
-        return conns;
+    for (const auto &dim : product) {
+        conns.push_back(dim.at(idx % dim.size()));
+        idx /= dim.size();
     }
 
-    for (const auto &set_itr : itrs) {
-        conns.push_back(*set_itr);
+    return conns;
+}
+
+// Returns the connections represented by each connection of the combination
+vector<vector<Connection>> ConnectionMatrix::members(size_t idx) const {
+    vector<vector<Connection>> members;
+
+    for (const auto &dim : product) {
+        members.push_back(dim.members(idx % dim.size()));
+        idx /= dim.size();
     }
 
-    // advance iterators
-    size_t i;
-    for (i = 0; i < product.size(); ++i) {
-        if (++itrs[i] != product[i].end()) {
-            break;
+    return members;
+}
+
+/**
+ * Returns the combinations in [begin, end), advancing the digits incrementally
+ * rather than decomposing every index.
+ */
+vector<vector<Connection>> ConnectionMatrix::range(size_t begin,
+                                                   size_t end) const {
+    vector<vector<Connection>> combinations;
+    end = min(end, size());
+    if (begin >= end) {
+        return combinations;
+    }
+
+    vector<size_t> digits;
+    for (size_t idx = begin; const auto &dim : product) {
+        digits.push_back(idx % dim.size());
+        idx /= dim.size();
+    }
+
+    for (size_t idx = begin; idx < end; ++idx) {
+        vector<Connection> conns;
+        for (size_t i = 0; i < product.size(); ++i) {
+            conns.push_back(product[i].at(digits[i]));
+        }
+        combinations.push_back(std::move(conns));
+
+        for (size_t i = 0; i < product.size(); ++i) {
+            if (++digits[i] != product[i].size()) {
+                break;
+            }
+            digits[i] = 0;
         }
-        itrs[i] = product[i].begin();
     }
-    if (i == product.size()) {
-        traversed_all = true;
+
+    return combinations;
+}
+
+/**
+ * Returns the sorted indices of n combinations sampled at random, stratified
+ * over the connection sets of the given sizes (least significant first). Like
+ * a Latin hypercube, each round of sampling splits every dimension into as many
+ * strata as the samples, and draws one value from each stratum, so that the
+ * connections of each set are covered as evenly as possible. The rounds are
+ * repeated for the duplicates.
+ */
+vector<size_t> ConnectionMatrix::sample(const vector<size_t> &dim_sizes,
+                                        size_t n,
+                                        uint64_t seed) {
+    size_t num = 1;
+    for (size_t radix : dim_sizes) {
+        num *= radix;
     }
+    mt19937_64 rng(seed);
 
-    return conns;
+    if (n * 2 >= num) {
+        vector<size_t> all(num);
+        iota(all.begin(), all.end(), 0);
+        if (n < num) {
+            shuffle(all.begin(), all.end(), rng);
+            all.resize(n);
+            sort(all.begin(), all.end());
+        }
+        return all;
+    }
+
+    set<size_t> sample;
+    while (sample.size() < n) {
+        const size_t m = n - sample.size();
+        vector<size_t> indices(m, 0);
+        size_t weight = 1;
+
+        for (size_t radix : dim_sizes) {
+            vector<size_t> values(m);
+            for (size_t i = 0; i < m; ++i) {
+                const size_t lb = i * radix / m;
+                const size_t ub = max(lb + 1, (i + 1) * radix / m);
+                values[i] = lb + rng() % (ub - lb);
+            }
+            shuffle(values.begin(), values.end(), rng);
+            for (size_t i = 0; i < m; ++i) {
+                indices[i] += values[i] * weight;
+            }
+            weight *= radix;
+        }
+
+        sample.insert(indices.begin(), indices.end());
+    }
+
+    return {sample.begin(), sample.end()};
 }
+
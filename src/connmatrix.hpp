@@ -1,20 +1,76 @@
 #pragma once
 
+#include <cstdint>
 #include <set>
 #include <vector>
 
 #include "conn.hpp"
 
+/**
+ * ConnectionSet is one dimension of the connection matrix, i.e., the
+ * independent connections of one ConnSpec. Unless the connections are listed
+ * explicitly (e.g., the representatives of symmetric connections), they are
+ * generated on demand from the source nodes, the destination IP ECs, and the
+ * destination ports. Each representative of symmetric connections keeps the
+ * connections it represents, which are reported along with its results.
+ *
+ * The connections are ordered by the source node names, the destination
+ * addresses (the lowest address of each EC), and the ports, rather than by the
+ * object addresses like a `std::set<Connection>`. The index of a connection is
+ * therefore the same in every process and every run over the same network,
+ * which shards, journals, and baselines rely on.
+ */
+class ConnectionSet {
+private:
+    bool is_explicit;
+    std::vector<Connection> conns; // explicit connections
+    std::vector<std::vector<Connection>> groups; // represented by each of conns
+    int protocol;
+    uint16_t src_port;
+    std::vector<Node *> src_nodes;
+    std::vector<EqClass *> dst_ip_ecs;
+    std::vector<uint16_t> dst_ports;
+
+public:
+    // Order of the connections that is the same in every process
+    static bool stable_less(const Connection &, const Connection &);
+
+    ConnectionSet(std::set<Connection> &&);
+    ConnectionSet(std::vector<std::vector<Connection>> &&groups);
+    ConnectionSet(int protocol,
+                  const std::set<Node *> &src_nodes,
+                  const std::set<EqClass *> &dst_ip_ecs,
+                  uint16_t src_port,
+                  const std::set<uint16_t> &dst_ports);
+
+    size_t size() const;
+    Connection at(size_t idx) const;
+    std::vector<Connection> members(size_t idx) const; // represented by at()
+};
+
+/**
+ * ConnectionMatrix is the Cartesian product of the connection sets of the
+ * concurrent connections, whose combinations (connection ECs) are addressed by
+ * their indices without being materialized. The index is a mixed-radix number,
+ * where the first connection set is the least significant digit, so that any
+ * subset of the ECs, e.g., a shard or a sample, can be generated independently.
+ */
 class ConnectionMatrix {
 private:
-    std::vector<std::set<Connection>> product;
-    std::vector<std::set<Connection>::iterator> itrs;
-    bool traversed_all = false;
+    std::vector<ConnectionSet> product;
+    size_t next_idx = 0; // index of the next combination of get_next_conns()
 
 public:
-    size_t num_conns() const;
+    size_t size() const;                   // number of combinations
+    std::vector<size_t> dim_sizes() const; // sizes of the connection sets
     void clear();
     void reset();
-    void add(std::set<Connection> &&);
+    void add(ConnectionSet &&);
     std::vector<Connection> get_next_conns();
+    std::vector<Connection> at(size_t idx) const;
+    std::vector<std::vector<Connection>> members(size_t idx) const;
+    std::vector<std::vector<Connection>> range(size_t begin, size_t end) const;
+
+    static std::vector<size_t>
+    sample(const std::vector<size_t> &dim_sizes, size_t n, uint64_t seed);
 };
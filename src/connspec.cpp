@@ -9,33 +9,31 @@ void ConnSpec::update_inv_ecs() const {
     EqClassMgr::get().add_ec(dst_ip);
 }
 
-std::set<Connection> ConnSpec::compute_connections() const {
-    std::set<Connection> conns;
+std::set<EqClass *> ConnSpec::compute_dst_ip_ecs() const {
+    return EqClassMgr::get().get_overlapped_ecs(dst_ip, owned_dst_only);
+}
 
-    // compute dst IP ECs
-    std::set<EqClass *> dst_ip_ecs =
-        EqClassMgr::get().get_overlapped_ecs(dst_ip, owned_dst_only);
-
-    // compute dst ports
-    std::set<uint16_t> dst_ports;
-    if (this->dst_ports.empty()) {
-        if (protocol == proto::tcp || protocol == proto::udp) {
-            dst_ports = EqClassMgr::get().ports();
-        } else { // ICMP
-            dst_ports.insert(0);
-        }
-    } else {
-        dst_ports = this->dst_ports;
+std::set<uint16_t> ConnSpec::compute_dst_ports() const {
+    if (!this->dst_ports.empty()) {
+        return this->dst_ports;
+    } else if (protocol == proto::tcp || protocol == proto::udp) {
+        return EqClassMgr::get().ports();
+    } else { // ICMP
+        return {0};
     }
+}
+
+ConnectionSet ConnSpec::connections() const {
+    return ConnectionSet(this->protocol, this->src_nodes, compute_dst_ip_ecs(),
+                         this->src_port, compute_dst_ports());
+}
+
+std::set<Connection> ConnSpec::compute_connections() const {
+    std::set<Connection> conns;
 
-    for (Node *src_node : this->src_nodes) {
-        for (EqClass *dst_ip_ec : dst_ip_ecs) {
-            for (uint16_t dst_port : dst_ports) {
-                Connection conn(this->protocol, src_node, dst_ip_ec,
-                                this->src_port, dst_port);
-                conns.insert(std::move(conn));
-            }
-        }
+    const ConnectionSet conn_set = connections();
+    for (size_t i = 0; i < conn_set.size(); ++i) {
+        conns.insert(conn_set.at(i));
     }
 
     return conns;
@@ -3,6 +3,7 @@
 #include <set>
 
 #include "conn.hpp"
+#include "connmatrix.hpp"
 #include "lib/ip.hpp"
 #include "node.hpp"
 
@@ -23,9 +24,12 @@ private:
 private:
     friend class ConfigParser;
     ConnSpec();
+    std::set<EqClass *> compute_dst_ip_ecs() const;
+    std::set<uint16_t> compute_dst_ports() const;
 
 public:
     ConnSpec(ConnSpec &&) = default;
     void update_inv_ecs() const;
+    ConnectionSet connections() const; // generated on demand
     std::set<Connection> compute_connections() const;
 };
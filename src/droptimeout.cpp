@@ -1,9 +1,13 @@
 #include "droptimeout.hpp"
 
+#include <cerrno>
 #include <cmath>
+#include <new>
+#include <sys/mman.h>
 #include <thread>
 
 #include "configparser.hpp"
+#include "logger.hpp"
 #include "stats.hpp"
 
 using namespace std;
@@ -11,7 +15,8 @@ using namespace std;
 DropTimeout::DropTimeout() :
     _has_initial_estimate(false),
     _nprocs(0),
-    _mdev_scalar(0) {}
+    _mdev_scalar(0),
+    _totals(nullptr) {}
 
 DropTimeout &DropTimeout::get() {
     static DropTimeout instance;
@@ -23,6 +28,15 @@ DropTimeout &DropTimeout::get() {
  * stores them in the `_lat_avg` and `_lat_mdev` fields
  */
 void DropTimeout::init() {
+    if (!_totals) {
+        void *addr = mmap(nullptr, sizeof(Totals), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            logger.error("mmap()", errno);
+        }
+        _totals = new (addr) Totals();
+    }
+
     if (_has_initial_estimate) {
         return;
     }
@@ -58,6 +72,11 @@ void DropTimeout::reset() {
     _has_initial_estimate = false;
     _nprocs = 0;
     _mdev_scalar = 0;
+
+    if (_totals) {
+        munmap(_totals, sizeof(Totals));
+        _totals = nullptr;
+    }
 }
 
 /**
@@ -101,8 +120,23 @@ void DropTimeout::adjust_latency_estimate_by_nprocs(int nprocs) {
  * RFC 9293 (https://datatracker.ietf.org/doc/html/rfc9293)
  */
 void DropTimeout::update_timeout() {
-    auto err = Stats::get().get_pkt_latencies().back() - _lat_avg;
+    const auto &latency = Stats::get().get_pkt_latencies().back();
+    if (_totals) {
+        _totals->sum.fetch_add(latency.count(), memory_order_relaxed);
+        _totals->count.fetch_add(1, memory_order_relaxed);
+    }
+
+    auto err = latency - _lat_avg;
     _lat_avg += err / 5;
     _lat_mdev += (chrono::abs(err) - _lat_mdev) / 5;
     _timeout = _lat_avg + _lat_mdev * _mdev_scalar;
 }
+
+/**
+ * Returns the sum and the number of the packet latencies observed by all the
+ * processes forked after init().
+ */
+void DropTimeout::latency_totals(uint64_t &sum, uint64_t &count) const {
+    sum = _totals ? _totals->sum.load(memory_order_relaxed) : 0;
+    count = _totals ? _totals->count.load(memory_order_relaxed) : 0;
+}
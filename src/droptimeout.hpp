@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 
 /**
  * @brief Packet injection latency and drop timeout estimate
@@ -11,6 +13,14 @@ private:
     bool _has_initial_estimate;
     int _nprocs, _mdev_scalar;
 
+    // Injection latencies of all the processes, in shared memory
+    struct Totals {
+        std::atomic<uint64_t> sum; // usec
+        std::atomic<uint64_t> count;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    Totals *_totals;
+
 private:
     friend class ConfigParser;
     DropTimeout();
@@ -34,4 +44,5 @@ public:
     void reset();
     void adjust_latency_estimate_by_nprocs(int nprocs);
     void update_timeout();
+    void latency_totals(uint64_t &sum, uint64_t &count) const;
 };
@@ -0,0 +1,71 @@
+#include "ecpriority.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "fib.hpp"
+#include "fibmgr.hpp"
+#include "node.hpp"
+
+using namespace std;
+
+/**
+ * Follows the FIBs of the connection from its source node, for any number of
+ * installed openflow updates. The paths are also used for planning (`--plan`).
+ */
+ECPriority::Paths ECPriority::trace(const Connection &conn) {
+    FIBMgr &fib_mgr = FIBMgr::get();
+    EqClass *dst_ip_ec = conn.get_dst_ip_ec();
+    Paths paths;
+    unordered_map<Node *, size_t> depths{{conn.get_src_node(), 0}};
+    deque<Node *> queue{conn.get_src_node()};
+
+    while (!queue.empty()) {
+        Node *node = queue.front();
+        queue.pop_front();
+        const size_t depth = depths.at(node);
+        paths.length = max(paths.length, depth);
+
+        if (node->is_emulated()) {
+            ++paths.middleboxes;
+        }
+
+        // Next hops for each number of installed openflow updates
+        const auto all_ipnhs = fib_mgr.get_all_ipnhs(dst_ip_ec, node);
+        const set<set<FIB_IPNH>> distinct(all_ipnhs.begin(), all_ipnhs.end());
+        if (distinct.size() > 1) {
+            ++paths.of_updates;
+        }
+
+        for (const auto &next_hops : distinct) {
+            if (next_hops.size() > 1) {
+                paths.branches += next_hops.size() - 1;
+            }
+            for (const FIB_IPNH &next_hop : next_hops) {
+                if (depths.emplace(next_hop.l3_node(), depth + 1).second) {
+                    queue.push_back(next_hop.l3_node());
+                }
+            }
+        }
+    }
+
+    return paths;
+}
+
+ECPriority::Score ECPriority::score(const vector<Connection> &conns,
+                                    bool violated_before) {
+    Score score;
+    score.violated_before = violated_before;
+
+    for (const Connection &conn : conns) {
+        const Paths paths = trace(conn);
+        score.middleboxes += paths.middleboxes;
+        score.of_updates += paths.of_updates;
+        score.branches += paths.branches;
+    }
+
+    return score;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <vector>
+
+#include "conn.hpp"
+
+/**
+ * ECPriority scores connection ECs by how likely they are to violate the
+ * invariant, so that the riskier ones are verified first (`--prioritize`) and a
+ * violation is found early when the verification stops at the first one.
+ *
+ * The score only looks at the precomputed data planes of the EC (see FIBMgr),
+ * following the FIBs of each connection from its source node. In decreasing
+ * order of importance, it consists of whether the EC was violated in the
+ * baseline run, the number of emulated middleboxes along the paths, the number
+ * of nodes whose next hops are changed by openflow updates, and the number of
+ * additional branches of multipath forwarding.
+ */
+class ECPriority {
+public:
+    // Forwarding paths of a connection
+    struct Paths {
+        size_t length = 0; // max number of hops
+        size_t middleboxes = 0;
+        size_t of_updates = 0;
+        size_t branches = 0;
+    };
+
+    struct Score {
+        bool violated_before = false;
+        size_t middleboxes = 0;
+        size_t of_updates = 0;
+        size_t branches = 0;
+
+        auto operator<=>(const Score &) const = default;
+    };
+
+    static Paths trace(const Connection &);
+    static Score score(const std::vector<Connection> &, bool violated_before);
+};
@@ -25,6 +25,17 @@ void EmulationMgr::reset() {
     _mb_emu_map.clear();
 }
 
+/**
+ * The emulations inherited by a forked process belong to the parent process,
+ * and their listener threads do not exist in the child. They are forgotten
+ * (and leaked) without tearing them down, so that the child starts its own
+ * emulations on demand.
+ */
+void EmulationMgr::detach() {
+    _emus.clear();
+    _mb_emu_map.clear();
+}
+
 Emulation *EmulationMgr::get_emulation(Middlebox *mb, NodePacketHistory *nph) {
     auto mb_map = _mb_emu_map.find(mb);
 
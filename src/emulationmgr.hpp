@@ -43,6 +43,7 @@ public:
     static EmulationMgr &get();
 
     void reset();
+    void detach(); // forget the emulations inherited from the parent process
     void max_emulations(decltype(_max_emu) n) { _max_emu = n; }
 
     Emulation *get_emulation(Middlebox *, NodePacketHistory *);
@@ -5,13 +5,14 @@
 
 class EqClass;
 #include "ecrange.hpp"
+#include "lib/idmap.hpp"
 
 /*
  * An EqClass (instance) is a set of ECRanges (a continuous range of IP
  * addresses), where any packet with its destination (or source) inside the
  * ranges has the same behavior. The ranges are disjoint.
  */
-class EqClass {
+class EqClass : public DenseID {
 private:
     std::set<ECRange> ranges;
 
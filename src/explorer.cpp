@@ -0,0 +1,327 @@
+#include "explorer.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "emulationmgr.hpp"
+#include "jobserver.hpp"
+#include "logger.hpp"
+#include "model-access.hpp"
+#include "plankton.hpp"
+#include "unique-storage.hpp"
+
+using namespace std;
+
+// Number of explored transitions between checks for idle job slots
+#define SPLIT_INTERVAL 256
+
+template <class T>
+static T *map_shared() {
+    void *addr = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        logger.error("mmap()", errno);
+    }
+    return new (addr) T();
+}
+
+Explorer::Explorer() :
+    _search(nullptr),
+    _variant(nullptr),
+    _state_size(0),
+    _max_depth(0),
+    _is_helper(false),
+    _truncated(false) {}
+
+Explorer::~Explorer() {
+    reset();
+}
+
+void Explorer::reset() {
+    if (_search) {
+        unshare_ids();
+        munmap(_search, sizeof(Search));
+    }
+
+    _search = nullptr;
+    _variant = nullptr;
+    _state_size = 0;
+    _max_depth = 0;
+    _visited.reset();
+    _frames.clear();
+    _data.reset();
+    _helpers.clear();
+    _is_helper = false;
+    _truncated = false;
+}
+
+State *Explorer::state(size_t depth) const {
+    return reinterpret_cast<State *>(_data.get() + depth * _state_size);
+}
+
+// Makes the state at the given depth the one accessed by the network model
+void Explorer::bind(size_t depth) const {
+    model.bind_state(state(depth));
+}
+
+/**
+ * Explores the given choice of the state on top of the DFS stack, and pushes
+ * the resulting state if it hasn't been visited.
+ */
+void Explorer::push(uint32_t choice) {
+    const size_t depth = _frames.size();
+    memcpy(state(depth), state(depth - 1), _state_size);
+    _variant->set_var[VAR_CHOICE](state(depth), choice);
+    bind(depth);
+    Plankton::get().exec_step();
+
+    if (_visited.insert(state(depth))) {
+        uint32_t count = _variant->get_var[VAR_CHOICE_COUNT](state(depth));
+        _frames.push_back({choice, 0, count});
+    } else {
+        bind(depth - 1);
+    }
+}
+
+void Explorer::pop() {
+    _frames.pop_back();
+    if (!_frames.empty()) {
+        bind(_frames.size() - 1);
+    }
+}
+
+/**
+ * Makes the ID maps of the model objects draw new IDs from the shared counters,
+ * so that the IDs in the visited states are consistent across the explorers.
+ */
+void Explorer::share_ids() {
+    constexpr size_t num_id_maps = tuple_size_v<decltype(storage.ids)> +
+                                   tuple_size_v<decltype(model.ids)>;
+    static_assert(num_id_maps <= extent_v<decltype(Search::next_ids)>);
+
+    atomic<uint32_t> *next = _search->next_ids;
+    auto share = [&next](auto &...id_maps) { (id_maps.share(next++), ...); };
+    apply(share, storage.ids);
+    apply(share, model.ids);
+}
+
+void Explorer::unshare_ids() {
+    auto unshare = [](auto &...id_maps) { (id_maps.unshare(), ...); };
+    apply(unshare, storage.ids);
+    apply(unshare, model.ids);
+}
+
+/**
+ * The search follows the control flow of the `init` process of network.pml:
+ * a state with choice_count > 0 has one transition per choice (exec_step),
+ * and a state with choice_count == 0 is an end state, where the invariant is
+ * checked (report).
+ */
+void Explorer::dfs(const string &trail) {
+    size_t steps = 0;
+
+    while (!_frames.empty() && !_search->stop.load(memory_order_relaxed)) {
+        const size_t depth = _frames.size() - 1;
+        Frame &frame = _frames.back();
+
+        if (frame.count == 0) {
+            Plankton::get().report();
+            if (_variant->get_var[VAR_VIOLATED](state(depth))) {
+                violation(trail);
+                break;
+            }
+        }
+
+        if (frame.next == frame.count) {
+            pop();
+            continue;
+        }
+
+        if (depth >= _max_depth) {
+            _truncated = true;
+            frame.next = frame.count;
+            continue;
+        }
+
+        push(frame.next++);
+
+        if (++steps % SPLIT_INTERVAL == 0) {
+            split();
+        }
+    }
+
+    if (_truncated) {
+        logger.warn("Max search depth too small (" + to_string(_max_depth) +
+                    "), the search is incomplete");
+    }
+}
+
+/**
+ * Hands the unexplored choices at the bottom of the DFS stack, which likely
+ * lead to the largest subtrees, over to a forked helper process if there is an
+ * idle job slot. The top frame is always kept, so that both processes have work
+ * to do.
+ */
+void Explorer::split() {
+    size_t depth = 0;
+    while (depth + 1 < _frames.size() &&
+           _frames[depth].next >= _frames[depth].count) {
+        ++depth;
+    }
+    if (depth + 1 >= _frames.size() || !JobServer::get().try_acquire()) {
+        return;
+    }
+
+    const pid_t ppid = getpid();
+    const pid_t pid = fork();
+
+    if (pid < 0) {
+        JobServer::get().release();
+        logger.warn("fork(): " + string(strerror(errno)));
+    } else if (pid == 0) {
+        // Exit along with the parent explorer
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != ppid) {
+            JobServer::get().release();
+            _exit(0);
+        }
+
+        _is_helper = true;
+        _helpers.clear();
+        _frames.resize(depth + 1);
+        bind(depth);
+        EmulationMgr::get().detach();
+        logger.info("Explorer helper forked at depth " + to_string(depth));
+    } else {
+        _helpers.push_back(pid);
+        _frames[depth].next = _frames[depth].count;
+    }
+}
+
+/**
+ * Writes the choices leading to the violating end state into the trail file,
+ * one per line, which stops the search of this EC (including the helpers).
+ */
+void Explorer::violation(const string &trail) {
+    if (_search->stop.exchange(true)) {
+        return; // already found by another explorer of this EC
+    }
+
+    ofstream ofs(trail);
+    for (size_t i = 1; i < _frames.size(); ++i) {
+        ofs << _frames[i].choice << endl;
+    }
+    logger.info("Trail written to " + trail);
+
+    // Invariant::report notifies the parent process, which is an explorer
+    // rather than the invariant process for helpers.
+    if (_is_helper) {
+        kill(_search->inv_pid, SIGUSR1);
+    }
+}
+
+/**
+ * Stops the search of this EC (including the helpers), which can't be
+ * concluded with the connections of the model variant.
+ */
+void Explorer::stop_conns_exceeded() const {
+    if (_search) {
+        _search->conns_exceeded.store(true);
+        _search->stop.store(true);
+    }
+}
+
+void Explorer::wait_helpers() {
+    if (_helpers.empty()) {
+        return;
+    }
+
+    // Lend our job slot while we are only waiting
+    JobServer::get().release();
+    for (pid_t pid : _helpers) {
+        // ECHILD: already reaped by the SIGCHLD handler
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR)
+            ;
+    }
+    while (!JobServer::get().acquire())
+        ;
+    _helpers.clear();
+}
+
+/**
+ * Explores the state space of the current EC within the memory budget (bytes)
+ * for the visited states. The visited states, the ID counters, and the search
+ * results are set up in shared memory before any helper is forked.
+ */
+void Explorer::explore(const model_variant *variant,
+                       size_t mem,
+                       size_t max_depth,
+                       const string &trail) {
+    const bool compact = variant->search_mode == SEARCH_HASHCOMPACT ||
+                         variant->search_mode == SEARCH_BITSTATE;
+    _variant = variant;
+    _state_size = variant->state_size;
+    _max_depth = max_depth;
+    _visited.init(StateSet::num_slots(mem, _state_size, compact), _state_size,
+                  compact);
+    _frames.clear();
+    _helpers.clear();
+    _truncated = false;
+
+    // The states of the DFS stack never move, as the model refers to them
+    _data = make_unique_for_overwrite<unsigned char[]>((max_depth + 1) *
+                                                       _state_size);
+
+    if (_search) {
+        unshare_ids();
+        munmap(_search, sizeof(Search));
+    }
+    _search = map_shared<Search>();
+    _search->inv_pid = getppid();
+    share_ids();
+
+    // Initial state
+    memset(state(0), 0, _state_size);
+    bind(0);
+    Plankton::get().initialize();
+    _visited.insert(state(0));
+    _frames.push_back({0, 0, _variant->get_var[VAR_CHOICE_COUNT](state(0))});
+
+    dfs(trail);
+    wait_helpers();
+
+    if (_is_helper) {
+        exit_helper(0);
+    }
+}
+
+/**
+ * Returns the job slot of a helper, and exits without running the destructors
+ * of the state inherited from the parent explorer (e.g., BPF programs). The
+ * emulations are torn down though, since the helper has detached the inherited
+ * ones, so those left are the ones it started itself. The helpers of a helper
+ * exit along with it.
+ */
+void Explorer::exit_helper(int status) const {
+    EmulationMgr::get().reset();
+    JobServer::get().release();
+    _exit(status);
+}
+
+// Counters of all the explorers of the EC, as they share the visited states
+uint64_t Explorer::states_stored() const {
+    return _visited.size();
+}
+
+uint64_t Explorer::hash_conflicts() const {
+    return _visited.conflicts();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "lib/state-set.hpp"
+#include "model-variant.h"
+
+/**
+ * Explorer is the native state-space explorer (`--engine native`), which
+ * drives initialize/exec_step/report of the network model directly over the
+ * state vectors of the loaded model variant, as an alternative to the
+ * Spin-generated verifier.
+ *
+ * The search is a DFS over full copies of the state vectors, with the visited
+ * states kept in a lock-free StateSet. Since the model objects referred to by
+ * the state vectors (and the middlebox emulations) are process-local, the
+ * search is parallelized by splitting rather than threads: whenever the
+ * jobserver has an idle job slot, a running explorer takes it by forking a
+ * helper process that continues with the unexplored choices at the bottom of
+ * the DFS stack. The explorers of an EC share the visited states, and draw the
+ * dense IDs of new model objects from shared counters, so that equal state
+ * vectors mean equal states in all of them.
+ */
+class Explorer {
+private:
+    // Per-EC search results shared by an explorer and its helpers
+    struct Search {
+        std::atomic<bool> stop;             // violation or conns_exceeded
+        std::atomic<bool> conns_exceeded;   // the model variant is too small
+        std::atomic<uint32_t> next_ids[16]; // dense ID counters (IDMap)
+        pid_t inv_pid;                      // invariant process
+    };
+
+    struct Frame {
+        uint32_t choice; // choice that led to this state
+        uint32_t next;   // next choice to explore
+        uint32_t count;  // number of choices (0: end state)
+    };
+
+    Search *_search;                        // shared memory mapping
+    const model_variant *_variant;          // model variant being explored
+    size_t _state_size;                     // bytes per state vector
+    size_t _max_depth;                      // max search depth
+    StateSet _visited;                      // visited states (shared)
+    std::vector<Frame> _frames;             // DFS stack
+    std::unique_ptr<unsigned char[]> _data; // state vectors, up to max depth
+    std::vector<pid_t> _helpers;            // helper processes forked by us
+    bool _is_helper;                        // whether we are a helper process
+    bool _truncated;                        // search depth limit reached
+
+    State *state(size_t depth) const;
+    void bind(size_t depth) const;
+    void push(uint32_t choice);
+    void pop();
+    void share_ids();
+    void unshare_ids();
+    void dfs(const std::string &trail);
+    void split();
+    void violation(const std::string &trail);
+    void wait_helpers();
+
+public:
+    Explorer();
+    Explorer(const Explorer &) = delete;
+    Explorer(Explorer &&) = delete;
+    ~Explorer();
+    Explorer &operator=(const Explorer &) = delete;
+    Explorer &operator=(Explorer &&) = delete;
+
+    void reset();
+
+    void explore(const model_variant *,
+                 size_t mem,
+                 size_t max_depth,
+                 const std::string &trail);
+    bool is_helper() const { return _is_helper; }
+    bool violation_found() const {
+        return _search && _search->stop.load() && !conns_exceeded();
+    }
+    bool conns_exceeded() const {
+        return _search && _search->conns_exceeded.load();
+    }
+    void stop_conns_exceeded() const;
+    [[noreturn]] void exit_helper(int status) const;
+    uint64_t states_stored() const;
+    uint64_t hash_conflicts() const;
+};
@@ -1,5 +1,11 @@
 #include "fib.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
 #include "interface.hpp"
 #include "lib/hash.hpp"
 #include "node.hpp"
@@ -94,41 +100,126 @@ size_t FIB_IPNH_Hash::operator()(const FIB_IPNH &next_hop) const {
 
 std::string FIB::to_string() const {
     std::string ret = "FIB:\n";
-    for (const auto &entry : _fib) {
-        ret += entry.first->to_string() + " -> [";
-        for (auto it = entry.second.begin(); it != entry.second.end(); ++it) {
-            ret += " " + it->to_string();
+    for (Node *node : _nodes) {
+        if (!node) {
+            continue;
+        }
+        ret += node->to_string() + " -> [";
+        for (const FIB_IPNH &next_hop : ipnhs(node->get_idx())) {
+            ret += " " + next_hop.to_string();
         }
         ret += " ]\n";
     }
     return ret;
 }
 
+/**
+ * Nodes without next hops make no difference to the hash, whether they are set
+ * or not. FIBEq still tells them apart.
+ */
+size_t FIB::entry_hash(Node *node, std::span<const FIB_IPNH> next_hops) {
+    if (next_hops.empty()) {
+        return 0;
+    }
+    size_t value = std::hash<Node *>()(node);
+    hash::hash_combine(value,
+                       hash::hash(next_hops.data(), next_hops.size_bytes()));
+    return hash::mix(value);
+}
+
+// Next hops of the node with the given index, which are empty if it is not set
+std::span<const FIB_IPNH> FIB::ipnhs(size_t idx) const {
+    if (idx + 1 >= _offsets.size()) {
+        return {};
+    }
+    return std::span<const FIB_IPNH>(_ipnhs.data() + _offsets[idx],
+                                     _offsets[idx + 1] - _offsets[idx]);
+}
+
+void FIB::set_ipnhs(Node *node, std::span<const FIB_IPNH> next_hops) {
+    const size_t idx = node->get_idx();
+    assert(idx != SIZE_MAX); // nodes are indexed by Network::add_node
+    if (idx + 1 >= _offsets.size()) {
+        _offsets.resize(idx + 2, _offsets.back());
+        _nodes.resize(idx + 1, nullptr);
+    }
+    _nodes[idx] = node;
+
+    _hash -= entry_hash(node, ipnhs(idx));
+    const auto begin = _ipnhs.begin() + _offsets[idx];
+    const auto end = _ipnhs.begin() + _offsets[idx + 1];
+    const ptrdiff_t delta = ptrdiff_t(next_hops.size()) - (end - begin);
+
+    if (delta == 0) {
+        std::copy(next_hops.begin(), next_hops.end(), begin);
+    } else {
+        const auto pos = _ipnhs.erase(begin, end);
+        _ipnhs.insert(pos, next_hops.begin(), next_hops.end());
+        for (size_t i = idx + 1; i < _offsets.size(); ++i) {
+            _offsets[i] = uint32_t(_offsets[i] + delta);
+        }
+    }
+    _hash += entry_hash(node, next_hops);
+}
+
 void FIB::set_ipnhs(Node *node, std::set<FIB_IPNH> &&next_hops) {
-    _fib[node] = next_hops;
+    const std::vector<FIB_IPNH> sorted(next_hops.begin(), next_hops.end());
+    set_ipnhs(node, std::span<const FIB_IPNH>(sorted));
 }
 
 void FIB::add_ipnh(Node *node, FIB_IPNH &&next_hop) {
-    _fib[node].insert(next_hop);
+    const auto current = ipnhs(node->get_idx());
+    std::vector<FIB_IPNH> sorted(current.begin(), current.end());
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), next_hop);
+    if (it != sorted.end() && *it == next_hop) {
+        return;
+    }
+    sorted.insert(it, std::move(next_hop));
+    set_ipnhs(node, std::span<const FIB_IPNH>(sorted));
 }
 
-const std::set<FIB_IPNH> &FIB::lookup(Node *const node) const {
-    return _fib.at(node);
+std::span<const FIB_IPNH> FIB::lookup(Node *const node) const {
+    const size_t idx = node->get_idx();
+    assert(idx != SIZE_MAX); // nodes are indexed by Network::add_node
+    if (idx >= _nodes.size() || _nodes[idx] != node) {
+        throw std::out_of_range("No FIB entry for " + node->get_name());
+    }
+    return ipnhs(idx);
 }
 
 size_t FIBHash::operator()(const FIB *const &fib) const {
-    size_t value = 0;
-    std::hash<Node *> node_hf;
-    FIB_IPNH_Hash ipnh_hf;
-    for (const auto &entry : fib->_fib) {
-        hash::hash_combine(value, node_hf(entry.first));
-        for (const auto &nh : entry.second) {
-            hash::hash_combine(value, ipnh_hf(nh));
-        }
-    }
-    return value;
+    return fib->_hash;
 }
 
+/**
+ * Compares the set nodes, the next hop arrays, and the offsets, where the nodes
+ * beyond the shorter arrays must not be set and have no next hops.
+ */
 bool FIBEq::operator()(const FIB *const &a, const FIB *const &b) const {
-    return a->_fib == b->_fib;
+    if (a->_hash != b->_hash || a->_ipnhs.size() != b->_ipnhs.size()) {
+        return false;
+    }
+    if (!a->_ipnhs.empty() &&
+        memcmp(a->_ipnhs.data(), b->_ipnhs.data(),
+               a->_ipnhs.size() * sizeof(FIB_IPNH)) != 0) {
+        return false;
+    }
+
+    const auto &short_nodes =
+        a->_nodes.size() < b->_nodes.size() ? a->_nodes : b->_nodes;
+    const auto &long_nodes = &short_nodes == &a->_nodes ? b->_nodes : a->_nodes;
+    if (!std::equal(short_nodes.begin(), short_nodes.end(),
+                    long_nodes.begin()) ||
+        !std::all_of(long_nodes.begin() + short_nodes.size(), long_nodes.end(),
+                     [](Node *node) { return node == nullptr; })) {
+        return false;
+    }
+
+    const auto &shorter =
+        a->_offsets.size() < b->_offsets.size() ? a->_offsets : b->_offsets;
+    const auto &longer = &shorter == &a->_offsets ? b->_offsets : a->_offsets;
+    return memcmp(shorter.data(), longer.data(),
+                  shorter.size() * sizeof(uint32_t)) == 0 &&
+           std::all_of(longer.begin() + shorter.size(), longer.end(),
+                       [&](uint32_t off) { return off == shorter.back(); });
 }
@@ -1,8 +1,12 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
 #include <set>
+#include <span>
 #include <string>
+#include <vector>
+
+#include "lib/idmap.hpp"
 
 class Node;
 class Interface;
@@ -33,6 +37,7 @@ public:
     FIB_IPNH(const FIB_IPNH &) = default;
     FIB_IPNH(FIB_IPNH &&) = default;
 
+    FIB_IPNH &operator=(const FIB_IPNH &) = default;
     FIB_IPNH &operator=(FIB_IPNH &&) = default;
 
     std::string to_string() const;
@@ -53,10 +58,24 @@ public:
 
 /**
  * An FIB holds the dataplane information for the current EC.
+ *
+ * The next hops are stored in a CSR layout indexed by the node indices (see
+ * Node::get_idx()): the sorted next hops of the node with index i are
+ * _ipnhs[_offsets[i] .. _offsets[i + 1]). Like a map, looking up a node that
+ * is not set throws std::out_of_range. Setting the nodes in the order of their indices only appends to the
+ * arrays, while setting any other node moves the next hops of the nodes after
+ * it.
  */
-class FIB {
+class FIB : public DenseID {
 private:
-    std::map<Node *, std::set<FIB_IPNH>> _fib;
+    std::vector<uint32_t> _offsets{0};
+    std::vector<FIB_IPNH> _ipnhs;
+    std::vector<Node *> _nodes; // nodes that are set, by index
+    size_t _hash = 0;           // sum of the mixed hashes of the entries
+
+    static size_t entry_hash(Node *, std::span<const FIB_IPNH>);
+    std::span<const FIB_IPNH> ipnhs(size_t idx) const;
+    void set_ipnhs(Node *, std::span<const FIB_IPNH>);
 
     friend class FIBHash;
     friend class FIBEq;
@@ -65,7 +84,7 @@ public:
     std::string to_string() const;
     void set_ipnhs(Node *, std::set<FIB_IPNH> &&);
     void add_ipnh(Node *, FIB_IPNH &&);
-    const std::set<FIB_IPNH> &lookup(Node *const) const;
+    std::span<const FIB_IPNH> lookup(Node *const) const;
 };
 
 class FIBHash {
@@ -0,0 +1,165 @@
+#include "fibmgr.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "eqclass.hpp"
+#include "logger.hpp"
+#include "network.hpp"
+#include "node.hpp"
+#include "process/openflow.hpp"
+#include "routingtable.hpp"
+#include "unique-storage.hpp"
+
+using namespace std;
+
+FIBMgr &FIBMgr::get() {
+    static FIBMgr instance;
+    return instance;
+}
+
+void FIBMgr::reset() {
+    _tables.clear();
+    _of_nodes.clear();
+    _fibs.clear();
+}
+
+/**
+ * Computes the FIB tables of all the given ECs with `nthreads` threads. Only
+ * the network, the routing tables, and the openflow updates are read, which are
+ * never modified after parsing.
+ */
+void FIBMgr::precompute(const set<EqClass *> &ecs,
+                        const Network &network,
+                        const OpenflowProcess &openflow,
+                        size_t nthreads) {
+    reset();
+
+    for (const auto &[node, _] : openflow.get_updates()) {
+        _of_nodes.push_back(node);
+    }
+
+    const vector<EqClass *> ec_list(ecs.begin(), ecs.end());
+    vector<ECTables> tables(ec_list.size());
+    atomic<size_t> next_ec(0);
+    exception_ptr error;
+    atomic<bool> failed(false);
+
+    auto worker = [&]() {
+        try {
+            size_t i;
+            while (!failed && (i = next_ec.fetch_add(1)) < ec_list.size()) {
+                tables[i] = compute_tables(ec_list[i], network, openflow);
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = current_exception();
+            }
+        }
+    };
+
+    nthreads = max<size_t>(1, min(nthreads, ec_list.size()));
+    vector<thread> threads;
+    for (size_t i = 1; i < nthreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        rethrow_exception(error);
+    }
+
+    for (size_t i = 0; i < ec_list.size(); ++i) {
+        _tables.emplace(ec_list[i], std::move(tables[i]));
+    }
+
+    logger.info("Precomputed FIBs for " + to_string(_tables.size()) +
+                " ECs with " + to_string(nthreads) + " threads");
+}
+
+FIBMgr::ECTables FIBMgr::compute_tables(EqClass *ec,
+                                        const Network &network,
+                                        const OpenflowProcess &openflow) {
+    ECTables tables;
+    IPv4Address addr = ec->representative_addr();
+
+    // collect IP next hops from routing tables, in the order of the indices
+    for (Node *node : network.nodes_by_idx()) {
+        tables.base_fib.set_ipnhs(node, node->get_ipnhs(addr));
+    }
+
+    // next hops of openflow nodes after installing each number of updates
+    for (const auto &[node, updates] : openflow.get_updates()) {
+        auto &node_ipnhs = tables.of_ipnhs.emplace_back();
+        RoutingTable of_rib = node->get_rib();
+        node_ipnhs.emplace_back(node->get_ipnhs(addr, &of_rib));
+
+        for (const Route &update : updates) {
+            if (update.relevant_to_ec(*ec)) {
+                of_rib.update(update);
+            }
+            node_ipnhs.emplace_back(node->get_ipnhs(addr, &of_rib));
+        }
+    }
+
+    return tables;
+}
+
+FIB *FIBMgr::get_fib(EqClass *ec, OpenflowUpdateState *update_state) {
+    auto fib_it = _fibs.find({ec, update_state});
+    if (fib_it != _fibs.end()) {
+        return fib_it->second;
+    }
+
+    auto tbl_it = _tables.find(ec);
+    if (tbl_it == _tables.end()) {
+        return nullptr;
+    }
+
+    const ECTables &tables = tbl_it->second;
+    FIB fib(tables.base_fib);
+
+    // install openflow updates that have been installed
+    for (size_t i = 0; i < _of_nodes.size(); ++i) {
+        size_t num_installed = update_state->num_of_installed_updates(i);
+        const set<FIB_IPNH> &next_hops = tables.of_ipnhs[i].at(num_installed);
+        if (!next_hops.empty()) {
+            fib.set_ipnhs(_of_nodes[i], set<FIB_IPNH>(next_hops));
+        }
+    }
+
+    FIB *stored = storage.store_fib(std::move(fib));
+    _fibs.emplace(make_pair(ec, update_state), stored);
+    return stored;
+}
+
+vector<set<FIB_IPNH>> FIBMgr::get_all_ipnhs(EqClass *ec, Node *node) const {
+    auto tbl_it = _tables.find(ec);
+    if (tbl_it == _tables.end()) {
+        return {};
+    }
+
+    const ECTables &tables = tbl_it->second;
+    auto node_it = find(_of_nodes.begin(), _of_nodes.end(), node);
+    const auto base_ipnhs = tables.base_fib.lookup(node);
+    if (node_it == _of_nodes.end()) {
+        return {set<FIB_IPNH>(base_ipnhs.begin(), base_ipnhs.end())};
+    }
+
+    // same as get_fib, where empty next hops fall back to the base FIB
+    vector<set<FIB_IPNH>> all_ipnhs;
+    for (const set<FIB_IPNH> &next_hops :
+         tables.of_ipnhs[node_it - _of_nodes.begin()]) {
+        if (next_hops.empty()) {
+            all_ipnhs.emplace_back(base_ipnhs.begin(), base_ipnhs.end());
+        } else {
+            all_ipnhs.push_back(next_hops);
+        }
+    }
+    return all_ipnhs;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fib.hpp"
+
+class EqClass;
+class Network;
+class Node;
+class OpenflowProcess;
+class OpenflowUpdateState;
+
+/**
+ * FIBMgr precomputes the data planes of all ECs before the connection EC
+ * processes are forked, so that they are shared copy-on-write by all the EC
+ * processes instead of being rebuilt in each of them.
+ *
+ * Since the next hops of an openflow node only depend on the EC and the number
+ * of updates installed at that node, each EC has a base FIB without any update
+ * installed, plus the next hops of every openflow node for every number of
+ * installed updates. The FIB of any (EC, openflow update state) is composed
+ * from these once and then memorized per process.
+ */
+class FIBMgr {
+private:
+    struct ECTables {
+        // FIB without any openflow update installed
+        FIB base_fib;
+        // [node order][number of installed updates] -> next hops
+        std::vector<std::vector<std::set<FIB_IPNH>>> of_ipnhs;
+    };
+
+    std::unordered_map<EqClass *, ECTables> _tables;
+    std::vector<Node *> _of_nodes; // openflow nodes by node order
+    std::map<std::pair<EqClass *, OpenflowUpdateState *>, FIB *> _fibs;
+
+    FIBMgr() = default;
+
+    static ECTables compute_tables(EqClass *,
+                                   const Network &,
+                                   const OpenflowProcess &);
+
+public:
+    // Disable the copy/move constructors and the assignment operators
+    FIBMgr(const FIBMgr &) = delete;
+    FIBMgr(FIBMgr &&) = delete;
+    FIBMgr &operator=(const FIBMgr &) = delete;
+    FIBMgr &operator=(FIBMgr &&) = delete;
+
+    static FIBMgr &get();
+
+    void reset();
+    void precompute(const std::set<EqClass *> &ecs,
+                    const Network &,
+                    const OpenflowProcess &,
+                    size_t nthreads);
+
+    // Returns nullptr if the EC isn't precomputed
+    FIB *get_fib(EqClass *, OpenflowUpdateState *);
+    // Returns the next hops of the node for each number of installed openflow
+    // updates, or an empty vector if the EC isn't precomputed
+    std::vector<std::set<FIB_IPNH>> get_all_ipnhs(EqClass *, Node *) const;
+};
@@ -1,30 +1,459 @@
 #include "injection-cache.hpp"
 
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <list>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "interface.hpp"
+#include "lib/hash.hpp"
+#include "logger.hpp"
+#include "payload.hpp"
+#include "payloadmgr.hpp"
+#include "unique-storage.hpp"
+
 using namespace std;
+namespace fs = std::filesystem;
 
 InjectionCache &injection_cache = InjectionCache::_get();
 
+InjectionCache::InjectionCache() :
+    _shm(nullptr), _slots(nullptr), _arena(nullptr), _shm_size(0),
+    _store_fd(-1) {}
+
+InjectionCache::~InjectionCache() {
+    close_store();
+    reset_shared();
+}
+
 InjectionCache &InjectionCache::_get() {
     static InjectionCache instance;
     return instance;
 }
 
+/**
+ * Drops all the cached results, whose middleboxes and interned results are
+ * freed along with the network and the storage.
+ */
+void InjectionCache::reset() {
+    _cache.clear();
+    close_store();
+    reset_shared();
+}
+
+/**
+ * Creates the shared tier. This must be called before forking any process that
+ * should share the cached results.
+ *
+ * @param num_slots number of hash table slots (a power of 2)
+ * @param arena_size number of bytes for the serialized records
+ */
+void InjectionCache::init_shared(size_t num_slots, size_t arena_size) {
+    assert((num_slots & (num_slots - 1)) == 0);
+    reset_shared();
+
+    _shm_size = sizeof(SharedHeader) + num_slots * sizeof(SharedSlot) +
+                arena_size;
+    // The pages are only backed by memory once touched.
+    void *addr = mmap(nullptr, _shm_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        logger.error("mmap()", errno);
+    }
+
+    _shm = new (addr) SharedHeader();
+    _shm->arena_top.store(sizeof(uint64_t)); // offset 0 means "being written"
+    _shm->num_slots = num_slots;
+    _shm->arena_size = arena_size;
+    _slots = reinterpret_cast<SharedSlot *>(_shm + 1);
+    _arena = reinterpret_cast<uint8_t *>(_slots + num_slots);
+}
+
+void InjectionCache::reset_shared() {
+    if (_shm) {
+        munmap(_shm, _shm_size);
+    }
+
+    _shm = nullptr;
+    _slots = nullptr;
+    _arena = nullptr;
+    _shm_size = 0;
+}
+
 void InjectionCache::insert(Middlebox *mb,
                             NodePacketHistory *nph,
                             InjectionResults *results) {
     _cache[mb][nph] = results;
+
+    if (_shm) {
+        string key = serialize_key(mb, nph);
+        string val = serialize_results(*results);
+        if (shared_insert(key, val) && _store_fd >= 0) {
+            store_append(key, val);
+        }
+    }
 }
 
 InjectionResults *InjectionCache::get(Middlebox *mb, NodePacketHistory *nph) {
     auto mb_it = _cache.find(mb);
-    if (mb_it == _cache.end()) {
+    if (mb_it != _cache.end()) {
+        auto nph_it = mb_it->second.find(nph);
+        if (nph_it != mb_it->second.end()) {
+            return nph_it->second;
+        }
+    }
+
+    if (!_shm) {
         return nullptr;
     }
 
-    auto nph_it = mb_it->second.find(nph);
-    if (nph_it == mb_it->second.end()) {
+    // Look up the results learned by other processes
+    size_t val_len;
+    const uint8_t *val = shared_find(serialize_key(mb, nph), val_len);
+    if (!val) {
         return nullptr;
     }
 
-    return nph_it->second;
+    InjectionResults *results = deserialize_results(mb, val, val_len);
+    _cache[mb][nph] = results;
+    return results;
+}
+
+/***** serialization *****/
+
+namespace {
+
+template <class T>
+void append(string &buf, const T &value) {
+    buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void append_packet(string &buf, const Packet &pkt) {
+    string intf_name = pkt.get_intf() ? pkt.get_intf()->get_name() : "";
+    append(buf, uint16_t(intf_name.size()));
+    buf.append(intf_name);
+    append(buf, pkt.get_src_ip().get_value());
+    append(buf, pkt.get_dst_ip().get_value());
+    append(buf, pkt.get_src_port());
+    append(buf, pkt.get_dst_port());
+    append(buf, pkt.get_seq());
+    append(buf, pkt.get_ack());
+    append(buf, pkt.get_proto_state());
+    Payload *pl = pkt.get_payload();
+    uint32_t pl_size = pl ? pl->get_size() : 0;
+    append(buf, pl_size);
+    if (pl_size > 0) {
+        buf.append(reinterpret_cast<const char *>(pl->get()), pl_size);
+    }
+}
+
+class Reader {
+private:
+    const uint8_t *_pos, *_end;
+
+    void check(size_t len) const {
+        if (_pos + len > _end) {
+            logger.error("Malformed cached injection results");
+        }
+    }
+
+public:
+    Reader(const uint8_t *data, size_t len) : _pos(data), _end(data + len) {}
+
+    template <class T>
+    T read() {
+        T value;
+        check(sizeof(T));
+        memcpy(&value, _pos, sizeof(T));
+        _pos += sizeof(T);
+        return value;
+    }
+
+    const uint8_t *read_bytes(size_t len) {
+        check(len);
+        const uint8_t *bytes = _pos;
+        _pos += len;
+        return bytes;
+    }
+};
+
+Packet read_packet(Reader &reader, Middlebox *mb) {
+    uint16_t name_len = reader.read<uint16_t>();
+    string intf_name(reinterpret_cast<const char *>(reader.read_bytes(name_len)),
+                     name_len);
+    Interface *intf = nullptr;
+    if (!intf_name.empty()) {
+        auto it = mb->get_intfs().find(intf_name);
+        if (it == mb->get_intfs().end()) {
+            logger.error("Unknown interface " + intf_name + " of " +
+                         mb->get_name());
+        }
+        intf = it->second;
+    }
+
+    IPv4Address src_ip(reader.read<uint32_t>());
+    IPv4Address dst_ip(reader.read<uint32_t>());
+    uint16_t src_port = reader.read<uint16_t>();
+    uint16_t dst_port = reader.read<uint16_t>();
+    uint32_t seq = reader.read<uint32_t>();
+    uint32_t ack = reader.read<uint32_t>();
+    uint16_t proto_state = reader.read<uint16_t>();
+    Packet pkt(intf, src_ip, dst_ip, src_port, dst_port, seq, ack,
+               proto_state);
+
+    uint32_t pl_size = reader.read<uint32_t>();
+    if (pl_size > 0) {
+        uint8_t *data = new uint8_t[pl_size];
+        memcpy(data, reader.read_bytes(pl_size), pl_size);
+        pkt.set_payload(PayloadMgr::get().get_payload(data, pl_size));
+    }
+    return pkt;
+}
+
+} // namespace
+
+/**
+ * The key is the middlebox name and config digest followed by the whole packet
+ * sequence that has been sent to the middlebox, which uniquely determines the
+ * middlebox state.
+ */
+string InjectionCache::serialize_key(Middlebox *mb, NodePacketHistory *nph) {
+    string key = mb->get_name();
+    key.push_back('\0');
+    append(key, uint64_t(mb->config_digest()));
+    if (nph) {
+        for (Packet *pkt : nph->get_packets()) {
+            append_packet(key, *pkt);
+        }
+    }
+    return key;
+}
+
+string InjectionCache::serialize_results(const InjectionResults &results) {
+    string val;
+    append(val, uint32_t(results.size()));
+    for (size_t i = 0; i < results.size(); ++i) {
+        const InjectionResult &result = results.at(i);
+        append(val, uint8_t(result.explicit_drop()));
+        append(val, uint32_t(result.recv_pkts().size()));
+        for (const Packet &pkt : result.recv_pkts()) {
+            append_packet(val, pkt);
+        }
+    }
+    return val;
+}
+
+InjectionResults *InjectionCache::deserialize_results(Middlebox *mb,
+                                                      const uint8_t *data,
+                                                      size_t len) {
+    Reader reader(data, len);
+    InjectionResults results;
+    uint32_t num_results = reader.read<uint32_t>();
+
+    for (uint32_t i = 0; i < num_results; ++i) {
+        bool explicit_drop = reader.read<uint8_t>();
+        uint32_t num_pkts = reader.read<uint32_t>();
+        list<Packet> recv_pkts;
+        for (uint32_t j = 0; j < num_pkts; ++j) {
+            recv_pkts.push_back(read_packet(reader, mb));
+        }
+        results.add(storage.store_injection_result(
+            InjectionResult(std::move(recv_pkts), explicit_drop)));
+    }
+
+    return storage.store_injection_results(std::move(results));
+}
+
+/***** shared tier *****/
+
+/**
+ * Each record in the arena consists of the key length (uint32_t), the value
+ * length (uint32_t), the key, and then the value. The full key is kept so that
+ * hash collisions never return wrong results.
+ */
+const uint8_t *InjectionCache::shared_find(const string &key,
+                                           size_t &val_len) const {
+    uint64_t h = ::hash::hash(key.data(), key.size());
+    h = h ? h : 1;
+    size_t mask = _shm->num_slots - 1;
+
+    for (size_t i = h & mask, n = 0; n < _shm->num_slots;
+         i = (i + 1) & mask, ++n) {
+        uint64_t slot_key = _slots[i].key.load(memory_order_acquire);
+        if (slot_key == 0) {
+            return nullptr;
+        }
+        if (slot_key != h) {
+            continue;
+        }
+
+        size_t offset = _slots[i].rec_offset.load(memory_order_acquire);
+        if (offset == 0) {
+            return nullptr; // still being written by another process
+        }
+
+        const uint8_t *rec = _arena + offset;
+        uint32_t rec_key_len, rec_val_len;
+        memcpy(&rec_key_len, rec, sizeof(uint32_t));
+        memcpy(&rec_val_len, rec + sizeof(uint32_t), sizeof(uint32_t));
+        const uint8_t *rec_key = rec + 2 * sizeof(uint32_t);
+        if (rec_key_len == key.size() &&
+            memcmp(rec_key, key.data(), key.size()) == 0) {
+            val_len = rec_val_len;
+            return rec_key + rec_key_len;
+        }
+    }
+
+    return nullptr;
+}
+
+bool InjectionCache::shared_insert(const string &key, const string &val) {
+    uint64_t h = ::hash::hash(key.data(), key.size());
+    h = h ? h : 1;
+    size_t mask = _shm->num_slots - 1;
+
+    for (size_t i = h & mask, n = 0; n < _shm->num_slots;
+         i = (i + 1) & mask, ++n) {
+        uint64_t expected = 0;
+        if (!_slots[i].key.compare_exchange_strong(expected, h,
+                                                   memory_order_acq_rel)) {
+            if (expected == h) {
+                // Already inserted (or being inserted) by another process. On
+                // a real hash collision the new results are only kept locally.
+                return false;
+            }
+            continue;
+        }
+
+        // Claimed an empty slot. Allocate the record from the arena.
+        size_t rec_size = 2 * sizeof(uint32_t) + key.size() + val.size();
+        rec_size = (rec_size + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+        size_t offset = _shm->arena_top.fetch_add(rec_size);
+        if (offset + rec_size > _shm->arena_size) {
+            logger.warn("Shared injection cache is full");
+            return false; // the slot stays claimed but never becomes readable
+        }
+
+        uint8_t *rec = _arena + offset;
+        uint32_t key_len = key.size(), val_len = val.size();
+        memcpy(rec, &key_len, sizeof(uint32_t));
+        memcpy(rec + sizeof(uint32_t), &val_len, sizeof(uint32_t));
+        memcpy(rec + 2 * sizeof(uint32_t), key.data(), key.size());
+        memcpy(rec + 2 * sizeof(uint32_t) + key.size(), val.data(), val.size());
+        _slots[i].rec_offset.store(offset, memory_order_release);
+        return true;
+    }
+
+    logger.warn("Shared injection cache is full");
+    return false;
+}
+
+/***** persistent store *****/
+
+/**
+ * Each record in the store file consists of the key length (uint32_t), the
+ * value length (uint32_t), a checksum of the key and value (uint64_t), the key,
+ * and then the value. A record is always appended with a single write, and a
+ * torn record at the end (e.g., from a killed run) is discarded when the store
+ * is opened.
+ */
+#define STORE_FILENAME   "injection-cache.bin"
+#define STORE_HDR_LEN    (2 * sizeof(uint32_t) + sizeof(uint64_t))
+
+/**
+ * Opens (or creates) the persistent store in the cache directory and loads all
+ * its records into the shared tier, which must have been initialized. This must
+ * be called before forking the verification tasks.
+ */
+void InjectionCache::open_store(const string &cache_dir) {
+    assert(_shm);
+    close_store();
+
+    fs::create_directories(cache_dir);
+    const auto path = fs::path(cache_dir) / STORE_FILENAME;
+    _store_fd = open(path.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (_store_fd < 0) {
+        logger.error("Failed to open " + path.string(), errno);
+    }
+
+    struct stat st;
+    if (fstat(_store_fd, &st) < 0) {
+        logger.error("fstat()", errno);
+    }
+
+    size_t file_size = st.st_size, offset = 0, num_records = 0;
+    if (file_size > 0) {
+        void *addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE,
+                          _store_fd, 0);
+        if (addr == MAP_FAILED) {
+            logger.error("mmap()", errno);
+        }
+
+        const uint8_t *data = static_cast<const uint8_t *>(addr);
+        while (offset + STORE_HDR_LEN <= file_size) {
+            uint32_t key_len, val_len;
+            uint64_t checksum;
+            memcpy(&key_len, data + offset, sizeof(uint32_t));
+            memcpy(&val_len, data + offset + sizeof(uint32_t),
+                   sizeof(uint32_t));
+            memcpy(&checksum, data + offset + 2 * sizeof(uint32_t),
+                   sizeof(uint64_t));
+            size_t rec_len = STORE_HDR_LEN + key_len + val_len;
+            const uint8_t *payload = data + offset + STORE_HDR_LEN;
+            if (offset + rec_len > file_size ||
+                ::hash::hash(payload, key_len + val_len) != checksum) {
+                break;
+            }
+
+            shared_insert(string(reinterpret_cast<const char *>(payload),
+                                 key_len),
+                          string(reinterpret_cast<const char *>(payload) +
+                                     key_len,
+                                 val_len));
+            offset += rec_len;
+            ++num_records;
+        }
+
+        munmap(addr, file_size);
+    }
+
+    if (offset < file_size) {
+        logger.warn("Discarding a torn record at the end of " + path.string());
+        if (ftruncate(_store_fd, offset) < 0) {
+            logger.error("ftruncate()", errno);
+        }
+    }
+
+    logger.info("Loaded " + to_string(num_records) +
+                " persistent injection results from " + path.string());
+}
+
+void InjectionCache::close_store() {
+    if (_store_fd >= 0) {
+        close(_store_fd);
+    }
+
+    _store_fd = -1;
+}
+
+void InjectionCache::store_append(const string &key, const string &val) {
+    string rec;
+    string payload = key + val;
+    append(rec, uint32_t(key.size()));
+    append(rec, uint32_t(val.size()));
+    append(rec, uint64_t(::hash::hash(payload.data(), payload.size())));
+    rec += payload;
+
+    // The file is opened with O_APPEND, so the concurrent appends from
+    // different processes don't overwrite each other.
+    ssize_t nwrite = write(_store_fd, rec.data(), rec.size());
+    if (nwrite != ssize_t(rec.size())) {
+        logger.warn("Failed to persist injection results");
+    }
 }
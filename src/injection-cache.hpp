@@ -1,11 +1,40 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <unordered_map>
 
 #include "injection-result.hpp"
 #include "middlebox.hpp"
 #include "pkt-hist.hpp"
 
+/**
+ * Default capacity of the shared tier. Since the mapping is created with
+ * MAP_NORESERVE, only the touched pages are backed by memory.
+ */
+#define SHARED_INJ_CACHE_SLOTS (1UL << 20)
+#define SHARED_INJ_CACHE_ARENA (1UL << 30)
+
+/**
+ * InjectionCache memorizes the injection results of each middlebox given the
+ * packet history of that middlebox.
+ *
+ * There are two tiers. The local tier maps the interned (Middlebox *,
+ * NodePacketHistory *) pointers to the interned results and is private to each
+ * process. The shared tier is an insert-only hash table in shared memory that
+ * is created by the main process before any verification tasks are forked, so
+ * that the results learned by one connection EC process are visible to all the
+ * others. Since pointers are meaningless across processes, the shared tier is
+ * keyed by the content of the middlebox name and the packet sequence, and the
+ * results are stored serialized.
+ *
+ * Optionally, the shared tier can be backed by an append-only record file in a
+ * cache directory, so that the results survive across runs. The middlebox
+ * config digest is part of the key, so the records become unreachable once the
+ * image or the configuration of a middlebox changes.
+ */
 class InjectionCache {
 private:
     std::unordered_map<
@@ -13,15 +42,50 @@ private:
         std::unordered_map<NodePacketHistory *, InjectionResults *>>
         _cache;
 
-    InjectionCache() = default;
+    struct SharedHeader {
+        std::atomic<size_t> arena_top; // offset of the next free arena byte
+        size_t num_slots;              // number of hash table slots
+        size_t arena_size;             // size of the record arena
+    };
+
+    struct SharedSlot {
+        std::atomic<uint64_t> key;      // content hash (0: empty slot)
+        std::atomic<size_t> rec_offset; // record offset (0: being written)
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    static_assert(std::atomic<size_t>::is_always_lock_free);
+
+    SharedHeader *_shm; // shared memory mapping (nullptr: disabled)
+    SharedSlot *_slots; // hash table slots (following the header)
+    uint8_t *_arena;    // serialized records (following the slots)
+    size_t _shm_size;   // size of the shared memory mapping
+    int _store_fd;      // persistent record file (-1: disabled)
+
+    InjectionCache();
+
+    static std::string serialize_key(Middlebox *, NodePacketHistory *);
+    static std::string serialize_results(const InjectionResults &);
+    static InjectionResults *deserialize_results(Middlebox *,
+                                                 const uint8_t *data,
+                                                 size_t len);
+    const uint8_t *shared_find(const std::string &key, size_t &val_len) const;
+    bool shared_insert(const std::string &key, const std::string &val);
+    void store_append(const std::string &key, const std::string &val);
 
 public:
     // Disable the copy constructor and the copy assignment operator
     InjectionCache(const InjectionCache &) = delete;
     InjectionCache &operator=(const InjectionCache &) = delete;
+    ~InjectionCache();
 
     static InjectionCache &_get();
 
+    void reset(); // all the tiers and the store
+    void init_shared(size_t num_slots, size_t arena_size);
+    void reset_shared();
+    void open_store(const std::string &cache_dir);
+    void close_store();
     void insert(Middlebox *, NodePacketHistory *, InjectionResults *);
     InjectionResults *get(Middlebox *, NodePacketHistory *);
 };
@@ -65,9 +65,11 @@ std::string InjectionResults::to_string() const {
 }
 
 void InjectionResults::add(InjectionResult *result) {
-    _results.insert(std::upper_bound(_results.begin(), _results.end(), result),
-                    result);
-    _results.erase(unique(_results.begin(), _results.end()), _results.end());
+    auto it = std::lower_bound(_results.begin(), _results.end(), result);
+    if (it == _results.end() || *it != result) {
+        _results.insert(it, result);
+        _hash += hash::mix(std::hash<InjectionResult *>()(result));
+    }
 }
 
 size_t InjectionResults::size() const {
@@ -80,8 +82,7 @@ const InjectionResult &InjectionResults::at(size_t i) const {
 
 size_t
 InjectionResultsHash::operator()(const InjectionResults *const &results) const {
-    return hash::hash(results->_results.data(),
-                      results->_results.size() * sizeof(InjectionResult *));
+    return results->_hash;
 }
 
 bool InjectionResultsEq::operator()(const InjectionResults *const &a,
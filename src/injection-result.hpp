@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "lib/idmap.hpp"
 #include "packet.hpp"
 
 class InjectionResult {
@@ -37,12 +38,13 @@ public:
                     const InjectionResult *const &) const;
 };
 
-class InjectionResults {
+class InjectionResults : public DenseID {
 private:
     // All elements in the vector should be sorted and unique.
     // Since we expect the number of duplicate injection results will be small,
     // using a vector should be more performant.
     std::vector<InjectionResult *> _results;
+    size_t _hash = 0; // sum of the mixed hashes of _results
 
     friend class InjectionResultsHash;
     friend class InjectionResultsEq;
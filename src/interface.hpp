@@ -2,9 +2,10 @@
 
 #include <string>
 
+#include "lib/idmap.hpp"
 #include "lib/ip.hpp"
 
-class Interface {
+class Interface : public DenseID {
 private:
     std::string name;
     IPInterface<IPv4Address> ipv4;
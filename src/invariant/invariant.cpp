@@ -1,11 +1,14 @@
 #include "invariant/invariant.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <csignal>
 #include <unistd.h>
 
 #include "logger.hpp"
 #include "model-access.hpp"
+#include "model-variant.h"
+#include "symmetry.hpp"
 
 Invariant::Invariant(bool correlated) {
     static int next_id = 1;
@@ -18,18 +21,28 @@ Invariant::Invariant(bool correlated) {
 
 size_t Invariant::num_conn_ecs() const {
     if (_correlated_invs.empty()) {
-        return _conn_matrix.num_conns();
+        return _conn_matrix.size();
     } else {
         size_t num = 1;
         for (const auto &p : _correlated_invs) {
-            num *= p->_conn_matrix.num_conns();
+            num *= p->_conn_matrix.size();
         }
         return num;
     }
 }
 
-void Invariant::compute_conn_matrix() {
-    // update invariant-wide ECs with invariant-aware ranges
+/**
+ * Returns the number of connections that are initially verified together. The
+ * correlated invariants are verified one after another with one connection.
+ */
+size_t Invariant::num_concurrent_conns() const {
+    return _correlated_invs.empty() ? _conn_specs.size() : 1;
+}
+
+/**
+ * Updates invariant-wide ECs with invariant-aware ranges.
+ */
+void Invariant::update_ecs() const {
     if (_correlated_invs.empty()) {
         for (const ConnSpec &conn_spec : _conn_specs) {
             conn_spec.update_inv_ecs();
@@ -39,17 +52,31 @@ void Invariant::compute_conn_matrix() {
             p->_conn_specs[0].update_inv_ecs();
         }
     }
+}
 
-    // gather _conn_specs' connections
+/**
+ * Gathers the connections of _conn_specs. With symmetry reduction, only one
+ * representative of each group of symmetric connections is verified, which
+ * keeps the connections it represents for reporting. The reduction needs the
+ * FIBs of all ECs to be precomputed, and only applies to the invariants with a
+ * single connection spec, since the concurrent connections would have to be
+ * relabeled together.
+ */
+void Invariant::compute_conn_matrix(bool symmetry) {
     if (_correlated_invs.empty()) {
         _conn_matrix.clear();
         for (const ConnSpec &conn_spec : _conn_specs) {
-            _conn_matrix.add(conn_spec.compute_connections());
+            if (symmetry && _conn_specs.size() == 1) {
+                _conn_matrix.add(Symmetry(distinguished_nodes())
+                                     .reduce(conn_spec.compute_connections()));
+            } else {
+                _conn_matrix.add(conn_spec.connections());
+            }
         }
     } else {
         for (const auto &p : _correlated_invs) {
             p->_conn_matrix.clear();
-            p->_conn_matrix.add(p->_conn_specs[0].compute_connections());
+            p->_conn_matrix.add(p->_conn_specs[0].connections());
         }
     }
 }
@@ -73,6 +100,74 @@ bool Invariant::set_conns() {
     }
 }
 
+void Invariant::set_conns(size_t conn_ec_idx) {
+    if (_correlated_invs.empty()) {
+        _conns = _conn_matrix.at(conn_ec_idx);
+    } else {
+        for (const auto &p : _correlated_invs) {
+            size_t n = p->_conn_matrix.size();
+            p->_conns = p->_conn_matrix.at(conn_ec_idx % n);
+            conn_ec_idx /= n;
+        }
+    }
+}
+
+/**
+ * Returns the connections represented by each connection of the EC, which are
+ * more than itself only if it represents symmetric connections.
+ */
+std::vector<std::vector<Connection>>
+Invariant::represented_conns(size_t conn_ec_idx) const {
+    if (_correlated_invs.empty()) {
+        return _conn_matrix.members(conn_ec_idx);
+    }
+
+    std::vector<std::vector<Connection>> members;
+    for (const auto &p : _correlated_invs) {
+        size_t n = p->_conn_matrix.size();
+        for (auto &conns : p->_conn_matrix.members(conn_ec_idx % n)) {
+            members.push_back(std::move(conns));
+        }
+        conn_ec_idx /= n;
+    }
+    return members;
+}
+
+/**
+ * Returns the connections of the current EC, which are those of the correlated
+ * invariants if there are any.
+ */
+std::vector<Connection> Invariant::all_conns() const {
+    std::vector<Connection> conns(_conns);
+    for (const auto &p : _correlated_invs) {
+        for (const Connection &conn : p->_conns) {
+            conns.push_back(conn);
+        }
+    }
+    return conns;
+}
+
+/**
+ * Returns the sorted indices of n connection ECs sampled at random, stratified
+ * over the connection sets of all the correlated invariants (see
+ * ConnectionMatrix::sample).
+ */
+std::vector<size_t> Invariant::sample_conn_ecs(size_t n, uint64_t seed) const {
+    // Mixed radixes of the EC indices (see set_conns), least significant first
+    std::vector<size_t> radixes;
+    if (_correlated_invs.empty()) {
+        radixes = _conn_matrix.dim_sizes();
+    } else {
+        for (const auto &p : _correlated_invs) {
+            for (size_t radix : p->_conn_matrix.dim_sizes()) {
+                radixes.push_back(radix);
+            }
+        }
+    }
+
+    return ConnectionMatrix::sample(radixes, n, seed);
+}
+
 std::string Invariant::conns_str() const {
     std::string ret;
     for (const Connection &conn : _conns) {
@@ -82,6 +177,26 @@ std::string Invariant::conns_str() const {
     return ret;
 }
 
+uint32_t Invariant::model_features() const {
+    if (_correlated_invs.empty()) {
+        return 0;
+    }
+
+    uint32_t features = MODEL_CORRELATED_INV_IDX;
+    for (const auto &p : _correlated_invs) {
+        features |= p->model_features();
+    }
+    return features;
+}
+
+/**
+ * Returns the nodes that the invariant refers to by identity, which are kept
+ * apart by symmetry reduction.
+ */
+std::unordered_set<Node *> Invariant::distinguished_nodes() const {
+    return {};
+}
+
 void Invariant::report() const {
     if (model.get_violated()) {
         logger.info("*** Invariant violated! ***");
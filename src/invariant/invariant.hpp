@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "conn.hpp"
@@ -10,6 +12,8 @@
 #define POL_NULL      0
 #define POL_REINIT_DP 1
 
+class Node;
+
 class Invariant {
 protected:
     int _id;
@@ -31,14 +35,23 @@ public:
 
     int id() const { return _id; }
     const decltype(_conns) &conns() const { return _conns; }
+    std::vector<Connection> all_conns() const; // including correlated ones
 
     size_t num_conn_ecs() const;
-    void compute_conn_matrix();
+    size_t num_concurrent_conns() const;
+    void update_ecs() const;
+    void compute_conn_matrix(bool symmetry);
     bool set_conns();
+    void set_conns(size_t conn_ec_idx); // random access, see ConnectionMatrix
+    std::vector<std::vector<Connection>>
+    represented_conns(size_t conn_ec_idx) const; // see Symmetry
+    std::vector<size_t> sample_conn_ecs(size_t n, uint64_t seed) const;
     std::string conns_str() const;
     void report() const;
 
     virtual std::string to_string() const = 0;
+    virtual uint32_t model_features() const; // optional state vars (MODEL_*)
+    virtual std::unordered_set<Node *> distinguished_nodes() const;
     virtual void init();
     virtual void reinit();
     virtual int check_violation() = 0;
@@ -1,6 +1,7 @@
 #include "invariant/loadbalance.hpp"
 
 #include "model-access.hpp"
+#include "model-variant.h"
 #include "node.hpp"
 #include "process/forwarding.hpp"
 #include "protocols.hpp"
@@ -18,6 +19,14 @@ string LoadBalance::to_string() const {
     return ret;
 }
 
+uint32_t LoadBalance::model_features() const {
+    return Invariant::model_features() | MODEL_REACH_COUNTS;
+}
+
+unordered_set<Node *> LoadBalance::distinguished_nodes() const {
+    return target_nodes;
+}
+
 void LoadBalance::init() {
     Invariant::init();
     model.set_violated(false);
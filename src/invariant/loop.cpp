@@ -10,6 +10,7 @@
 #include "lib/hash.hpp"
 #include "logger.hpp"
 #include "model-access.hpp"
+#include "model-variant.h"
 #include "node.hpp"
 #include "process/forwarding.hpp"
 #include "protocols.hpp"
@@ -20,6 +21,10 @@ string Loop::to_string() const {
     return "Loop invariant";
 }
 
+uint32_t Loop::model_features() const {
+    return Invariant::model_features() | MODEL_VISITED_HOPS;
+}
+
 void Loop::init() {
     Invariant::init();
     model.set_violated(false);
@@ -89,7 +94,7 @@ int Loop::check_violation() {
 
 bool VisitedHops::visited(
     const std::tuple<EqClass *, uint16_t, Node *> &hop) const {
-    return _hops.count(hop) > 0 && _last_hop != hop;
+    return _hops.find(hop) && _last_hop != hop;
 }
 
 bool VisitedHops::is_last_hop(
@@ -97,24 +102,26 @@ bool VisitedHops::is_last_hop(
     return _last_hop == hop;
 }
 
+size_t VisitedHops::HopHash::operator()(const Hop &hop) const {
+    size_t value = std::hash<EqClass *>()(std::get<0>(hop));
+    ::hash::hash_combine(value, std::hash<uint16_t>()(std::get<1>(hop)));
+    ::hash::hash_combine(value, std::hash<Node *>()(std::get<2>(hop)));
+    return value;
+}
+
 void VisitedHops::add(std::tuple<EqClass *, uint16_t, Node *> &&hop) {
-    auto res = _hops.insert(std::move(hop));
-    if (!res.second) {
+    if (!_hops.assign(hop, true)) {
         logger.error("Adding a duplicate hop. Loop invariant should have been "
                      "violated!");
     }
+    _hash += ::hash::mix(HopHash()(hop));
 }
 
 size_t VisitedHopsHash::operator()(const VisitedHops *const &hops) const {
-    size_t value = 0;
+    size_t value = hops->_hash;
     std::hash<EqClass *> ec_hasher;
     std::hash<uint16_t> port_hasher;
     std::hash<Node *> node_hasher;
-    for (const auto &hop : hops->_hops) {
-        ::hash::hash_combine(value, ec_hasher(std::get<0>(hop)));
-        ::hash::hash_combine(value, port_hasher(std::get<1>(hop)));
-        ::hash::hash_combine(value, node_hasher(std::get<2>(hop)));
-    }
     ::hash::hash_combine(value, ec_hasher(std::get<0>(hops->_last_hop)));
     ::hash::hash_combine(value, port_hasher(std::get<1>(hops->_last_hop)));
     ::hash::hash_combine(value, node_hasher(std::get<2>(hops->_last_hop)));
@@ -123,5 +130,6 @@ size_t VisitedHopsHash::operator()(const VisitedHops *const &hops) const {
 
 bool VisitedHopsEq::operator()(const VisitedHops *const &a,
                                const VisitedHops *const &b) const {
-    return a->_hops == b->_hops && a->_last_hop == b->_last_hop;
+    return a->_hash == b->_hash && a->_hops == b->_hops &&
+           a->_last_hop == b->_last_hop;
 }
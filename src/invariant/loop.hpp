@@ -1,12 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <set>
 #include <string>
 #include <tuple>
 
 #include "eqclass.hpp"
 #include "invariant/invariant.hpp"
+#include "lib/idmap.hpp"
+#include "lib/persistent-map.hpp"
 #include "node.hpp"
 
 /**
@@ -19,14 +21,25 @@ private:
 
 public:
     std::string to_string() const override;
+    uint32_t model_features() const override;
     void init() override;
     int check_violation() override;
 };
 
-class VisitedHops {
+/**
+ * VisitedHops is the set of hops visited by the packet, in a persistent map
+ * (whose values are unused), so that adding a hop does not copy the others.
+ */
+class VisitedHops : public DenseID {
 private:
-    std::set<std::tuple<EqClass *, uint16_t, Node *>> _hops;
+    using Hop = std::tuple<EqClass *, uint16_t, Node *>;
+    struct HopHash {
+        size_t operator()(const Hop &) const;
+    };
+
+    PersistentMap<Hop, bool, HopHash> _hops;
     std::tuple<EqClass *, uint16_t, Node *> _last_hop;
+    size_t _hash = 0; // sum of the mixed hashes of _hops
 
     friend class VisitedHopsHash;
     friend class VisitedHopsEq;
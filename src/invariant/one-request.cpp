@@ -1,6 +1,7 @@
 #include "invariant/one-request.hpp"
 
 #include "model-access.hpp"
+#include "model-variant.h"
 #include "node.hpp"
 #include "process/forwarding.hpp"
 #include "protocols.hpp"
@@ -17,6 +18,14 @@ string OneRequest::to_string() const {
     return ret;
 }
 
+uint32_t OneRequest::model_features() const {
+    return Invariant::model_features() | MODEL_REACH_COUNTS;
+}
+
+unordered_set<Node *> OneRequest::distinguished_nodes() const {
+    return target_nodes;
+}
+
 void OneRequest::init() {
     Invariant::init();
     model.set_violated(true);
@@ -20,6 +20,8 @@ private:
 
 public:
     std::string to_string() const override;
+    uint32_t model_features() const override;
+    std::unordered_set<Node *> distinguished_nodes() const override;
     void init() override;
     int check_violation() override;
 };
@@ -18,6 +18,10 @@ string Reachability::to_string() const {
     return ret;
 }
 
+unordered_set<Node *> Reachability::distinguished_nodes() const {
+    return target_nodes;
+}
+
 void Reachability::init() {
     Invariant::init();
     model.set_violated(false);
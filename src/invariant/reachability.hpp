@@ -23,6 +23,7 @@ private:
 
 public:
     std::string to_string() const override;
+    std::unordered_set<Node *> distinguished_nodes() const override;
     void init() override;
     int check_violation() override;
 };
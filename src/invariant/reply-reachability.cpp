@@ -18,6 +18,10 @@ string ReplyReachability::to_string() const {
     return ret;
 }
 
+unordered_set<Node *> ReplyReachability::distinguished_nodes() const {
+    return target_nodes;
+}
+
 void ReplyReachability::init() {
     Invariant::init();
     model.set_violated(false);
@@ -18,6 +18,10 @@ string Waypoint::to_string() const {
     return ret;
 }
 
+unordered_set<Node *> Waypoint::distinguished_nodes() const {
+    return target_nodes;
+}
+
 void Waypoint::init() {
     Invariant::init();
     model.set_violated(false);
@@ -0,0 +1,174 @@
+#include "jobcontroller.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "droptimeout.hpp"
+#include "jobserver.hpp"
+#include "logger.hpp"
+
+using namespace std;
+
+// Interval between adjustments
+#define UPDATE_INTERVAL chrono::seconds(2)
+
+// Thresholds of CPU utilization, latency inflation, and available memory
+#define CPU_HIGH        0.95
+#define CPU_LOW         0.80
+#define LAT_HIGH        2.0
+#define LAT_LOW         1.5
+#define MEM_LOW         0.10
+#define MEM_RESERVE     0.20
+
+JobController::JobController() :
+    _enabled(false), _min_jobs(0), _max_jobs(0), _target(0), _issued(0),
+    _cpu_busy(0), _cpu_total(0), _lat_sum(0), _lat_count(0), _mem_base(0),
+    _lat_base(0) {}
+
+void JobController::init(size_t min_jobs,
+                         size_t max_jobs,
+                         size_t initial_jobs) {
+    _enabled = true;
+    _min_jobs = min_jobs;
+    _max_jobs = max_jobs;
+    _target = _issued = initial_jobs;
+    _last_update = chrono::steady_clock::now();
+    sample_cpu(_cpu_busy, _cpu_total);
+    DropTimeout::get().latency_totals(_lat_sum, _lat_count);
+    _lat_base = max<double>(1, DropTimeout::get().lat_avg().count());
+
+    uint64_t mem_total, mem_avail;
+    sample_mem(mem_total, mem_avail);
+    _mem_base = mem_total - mem_avail;
+
+    logger.info("Adaptive jobs: " + to_string(_target) + " in [" +
+                to_string(_min_jobs) + ", " + to_string(_max_jobs) + "]");
+}
+
+void JobController::reset() {
+    _enabled = false;
+    _min_jobs = 0;
+    _max_jobs = 0;
+    _target = 0;
+    _issued = 0;
+    _cpu_busy = 0;
+    _cpu_total = 0;
+    _lat_sum = 0;
+    _lat_count = 0;
+    _mem_base = 0;
+    _lat_base = 0;
+}
+
+// Returns the busy and total CPU time of all CPUs (/proc/stat)
+void JobController::sample_cpu(uint64_t &busy, uint64_t &total) const {
+    ifstream ifs("/proc/stat");
+    string cpu;
+    uint64_t value;
+
+    busy = total = 0;
+    ifs >> cpu;
+    for (int i = 0; i < 8 && ifs >> value; ++i) {
+        total += value;
+        if (i != 3 && i != 4) { // idle, iowait
+            busy += value;
+        }
+    }
+}
+
+// Returns MemTotal and MemAvailable of /proc/meminfo in bytes
+void JobController::sample_mem(uint64_t &total, uint64_t &avail) const {
+    ifstream ifs("/proc/meminfo");
+    string line;
+
+    total = avail = 0;
+    while (getline(ifs, line)) {
+        if (line.starts_with("MemTotal:")) {
+            total = stoull(line.substr(9)) * 1024;
+        } else if (line.starts_with("MemAvailable:")) {
+            avail = stoull(line.substr(13)) * 1024;
+        }
+    }
+}
+
+/**
+ * Samples the resource usage since the last update, and adjusts the target
+ * number of tokens accordingly. It is called by the main process whenever it
+ * wakes up, and does nothing within UPDATE_INTERVAL of the last update.
+ */
+void JobController::update() {
+    const auto now = chrono::steady_clock::now();
+    if (!_enabled || now - _last_update < UPDATE_INTERVAL) {
+        return;
+    }
+    _last_update = now;
+
+    // CPU utilization
+    uint64_t cpu_busy, cpu_total;
+    sample_cpu(cpu_busy, cpu_total);
+    const double cpu = cpu_total > _cpu_total
+                           ? double(cpu_busy - _cpu_busy) /
+                                 (cpu_total - _cpu_total)
+                           : 0;
+    _cpu_busy = cpu_busy;
+    _cpu_total = cpu_total;
+
+    // Latency inflation over the initial estimate
+    uint64_t lat_sum, lat_count;
+    DropTimeout::get().latency_totals(lat_sum, lat_count);
+    const double lat = lat_count > _lat_count
+                           ? double(lat_sum - _lat_sum) /
+                                 (lat_count - _lat_count) / _lat_base
+                           : 1;
+    _lat_sum = lat_sum;
+    _lat_count = lat_count;
+
+    // Available memory, and the memory used by each running task
+    uint64_t mem_total, mem_avail;
+    sample_mem(mem_total, mem_avail);
+    const double mem = double(mem_avail) / max<uint64_t>(1, mem_total);
+    const size_t idle = JobServer::get().idle();
+    const size_t running = _issued > idle ? _issued - idle : 0;
+    const double mem_per_task =
+        double(max(mem_total - mem_avail, _mem_base) - _mem_base) /
+        max<size_t>(1, running);
+
+    const size_t orig_target = _target;
+    if (mem < MEM_LOW) {
+        _target -= max<size_t>(1, _target / 4);
+    } else if (cpu > CPU_HIGH || lat > LAT_HIGH) {
+        _target -= 1;
+    } else if (idle == 0 && cpu < CPU_LOW && lat < LAT_LOW &&
+               mem_avail > mem_total * MEM_RESERVE + mem_per_task) {
+        _target += 1;
+    }
+    _target = clamp(_target, _min_jobs, _max_jobs);
+
+    if (_target != orig_target) {
+        ostringstream reason;
+        reason.precision(2);
+        reason << fixed << "CPU " << cpu * 100 << "%, latency x" << lat
+               << ", memory available " << mem * 100 << "%";
+        logger.info("Adaptive jobs: " + to_string(orig_target) + " -> " +
+                    to_string(_target) + " (" + reason.str() + ")");
+    }
+
+    adjust_tokens();
+}
+
+/**
+ * Adds tokens to the jobserver, or withholds the released ones, until the
+ * number of tokens in circulation reaches the target.
+ */
+void JobController::adjust_tokens() {
+    JobServer &jobserver = JobServer::get();
+
+    while (_issued < _target) {
+        jobserver.release();
+        ++_issued;
+    }
+    while (_issued > _target && jobserver.try_acquire()) {
+        --_issued;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * JobController adapts the number of concurrent EC tasks (`--adaptive-jobs`)
+ * by adding job tokens to or withholding them from the jobserver, within
+ * [min, max] tokens.
+ *
+ * It is updated periodically by the main process. The concurrency is increased
+ * by one (additive increase) if all the tokens are in use, the CPUs aren't
+ * saturated, the injection latencies aren't inflated, and there is enough
+ * memory for another task. Since EC tasks mostly wait for injected packets, the
+ * concurrency may go beyond the number of CPUs as long as they are idle. It is
+ * decreased by one if the CPUs are saturated or the latencies are inflated, and
+ * by a quarter (multiplicative decrease) under memory pressure. Withheld tokens
+ * are taken as they are released by the tasks.
+ */
+class JobController {
+private:
+    bool _enabled;
+    size_t _min_jobs, _max_jobs;
+    size_t _target;  // target number of tokens
+    size_t _issued;  // number of tokens in circulation
+    std::chrono::steady_clock::time_point _last_update;
+    uint64_t _cpu_busy, _cpu_total;  // CPU time (/proc/stat)
+    uint64_t _lat_sum, _lat_count;   // injection latencies of all tasks
+    uint64_t _mem_base;              // memory in use before verification
+    double _lat_base;                // initial latency estimate (usec)
+
+    void sample_cpu(uint64_t &busy, uint64_t &total) const;
+    void sample_mem(uint64_t &total, uint64_t &avail) const;
+    void adjust_tokens();
+
+public:
+    JobController();
+
+    void init(size_t min_jobs, size_t max_jobs, size_t initial_jobs);
+    void reset();
+    bool enabled() const { return _enabled; }
+    void update();
+};
@@ -0,0 +1,106 @@
+#include "jobserver.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <string>
+#include <unistd.h>
+
+#include "logger.hpp"
+
+using namespace std;
+
+JobServer::JobServer() : _rfd(-1), _wfd(-1) {}
+
+JobServer::~JobServer() {
+    reset();
+}
+
+JobServer &JobServer::get() {
+    static JobServer instance;
+    return instance;
+}
+
+void JobServer::init(size_t tokens) {
+    reset();
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        logger.error("pipe2()", errno);
+    }
+    _rfd = fds[0];
+    _wfd = fds[1];
+
+    if (fcntl(_rfd, F_SETFL, O_NONBLOCK) < 0) {
+        logger.error("fcntl()", errno);
+    }
+
+    const string buf(tokens, '+');
+    if (write(_wfd, buf.data(), buf.size()) != ssize_t(buf.size())) {
+        logger.error("Failed to fill the jobserver with " + to_string(tokens) +
+                     " tokens");
+    }
+}
+
+void JobServer::reset() {
+    if (_rfd >= 0) {
+        close(_rfd);
+    }
+    if (_wfd >= 0) {
+        close(_wfd);
+    }
+
+    _rfd = -1;
+    _wfd = -1;
+}
+
+bool JobServer::acquire() const {
+    while (!try_acquire()) {
+        struct pollfd pfd = {.fd = _rfd, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) {
+                return false;
+            }
+            logger.error("poll()", errno);
+        }
+    }
+    return true;
+}
+
+bool JobServer::try_acquire() const {
+    char token;
+    ssize_t nread;
+
+    if (_rfd < 0) {
+        return false;
+    }
+
+    while ((nread = read(_rfd, &token, 1)) < 0 && errno == EINTR)
+        ;
+
+    if (nread == 1) {
+        return true;
+    } else if (nread < 0 && errno != EAGAIN) {
+        logger.error("read()", errno);
+    }
+    return false;
+}
+
+void JobServer::release() const {
+    const char token = '+';
+
+    if (_wfd >= 0) {
+        while (write(_wfd, &token, 1) < 0 && errno == EINTR)
+            ;
+    }
+}
+
+size_t JobServer::idle() const {
+    int nbytes = 0;
+
+    if (_rfd >= 0 && ioctl(_rfd, FIONREAD, &nbytes) < 0) {
+        logger.error("ioctl()", errno);
+    }
+    return nbytes;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * A make-style jobserver that bounds the number of concurrent verification
+ * tasks across the whole process tree.
+ *
+ * The main process creates a pipe holding one token (byte) per job slot before
+ * forking the invariant processes, so that the pipe is inherited by all the
+ * processes. An invariant process takes a token before forking each EC process,
+ * and puts it back after reaping the child, so that the freed
+ * slot goes to whichever process takes it first, i.e., an invariant process
+ * with pending ECs or a native explorer (see Explorer::split). The read end is
+ * non-blocking, and blocking reads wait with poll() instead.
+ */
+class JobServer {
+private:
+    int _rfd, _wfd; // read and write ends of the token pipe
+
+    JobServer();
+
+public:
+    // Disable the copy/move constructors and the assignment operators
+    JobServer(const JobServer &) = delete;
+    JobServer(JobServer &&) = delete;
+    JobServer &operator=(const JobServer &) = delete;
+    JobServer &operator=(JobServer &&) = delete;
+    ~JobServer();
+
+    static JobServer &get();
+
+    void init(size_t tokens);
+    void reset();
+    bool acquire() const;     // false if interrupted by a signal
+    bool try_acquire() const; // false if no token is available
+    void release() const;     // async-signal-safe
+    size_t idle() const;      // number of available tokens
+};
@@ -0,0 +1,219 @@
+#include "journal.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "logger.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Min interval between non-forced flushes of the journal to disk
+#define SYNC_INTERVAL chrono::seconds(1)
+
+Journal::Journal() : _fd(-1) {}
+
+Journal::~Journal() {
+    reset();
+}
+
+/**
+ * Malformed lines, e.g., one that was being written when the machine crashed,
+ * are skipped. A later start of the same invariant discards its earlier
+ * results.
+ */
+map<int, Journal::InvResults> Journal::read(const fs::path &path) {
+    map<int, InvResults> invs;
+    ifstream ifs(path);
+    string line;
+
+    while (getline(ifs, line)) {
+        istringstream iss(line);
+        char type;
+        int inv_id;
+        size_t n;
+
+        if (!(iss >> type >> inv_id >> n)) {
+            continue;
+        }
+
+        if (type == 'I') {
+            InvResults &inv = invs[inv_id];
+            inv.num_ecs = n;
+            inv.results.clear();
+            iss.ignore(1);
+            getline(iss, inv.inv);
+        } else if (type == 'E' && invs.count(inv_id) > 0) {
+            Result res;
+            if (iss >> res.violated >> res.time >> res.peak_rss >>
+                res.states_stored >> res.hash_conflicts) {
+                iss.ignore(1);
+                getline(iss, res.conns);
+                invs[inv_id].results[n] = std::move(res);
+            }
+        }
+    }
+
+    return invs;
+}
+
+/**
+ * Opens the journal of the output directory. Without `resume`, the journal is
+ * truncated.
+ */
+void Journal::open(const fs::path &out_dir, bool resume) {
+    reset();
+
+    const fs::path path = out_dir / "journal";
+    int flags = O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC;
+    if (resume) {
+        _invs = read(path);
+        size_t num_ecs = 0;
+        for (const auto &[_, inv] : _invs) {
+            num_ecs += inv.results.size();
+        }
+        logger.info("Resuming with " + to_string(num_ecs) +
+                    " finished connection ECs from " + path.string());
+    } else {
+        flags |= O_TRUNC;
+    }
+
+    _fd = ::open(path.c_str(), flags, 0644);
+    if (_fd < 0) {
+        logger.error("Failed to open " + path.string(), errno);
+    }
+    _last_sync = chrono::steady_clock::now();
+}
+
+void Journal::reset() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+
+    _fd = -1;
+    _invs.clear();
+}
+
+void Journal::append(const string &line) const {
+    if (_fd < 0) {
+        return;
+    }
+
+    // A single write() so that concurrent appends aren't interleaved
+    if (write(_fd, line.data(), line.size()) != ssize_t(line.size())) {
+        logger.warn("Failed to write the journal: " + line);
+    }
+}
+
+/**
+ * Starts journaling an invariant. The results loaded for the invariant are
+ * discarded if it has changed since, in which case the EC indices no longer
+ * refer to the same ECs.
+ */
+void Journal::begin_invariant(int inv_id, size_t num_ecs, const string &inv) {
+    auto it = _invs.find(inv_id);
+    if (it != _invs.end() && it->second.num_ecs == num_ecs &&
+        it->second.inv == inv) {
+        return;
+    }
+
+    if (it != _invs.end()) {
+        logger.warn("Invariant " + to_string(inv_id) +
+                    " has changed since the journal was written");
+    }
+    _invs[inv_id] = {num_ecs, inv, {}};
+    append("I " + to_string(inv_id) + " " + to_string(num_ecs) + " " + inv +
+           "\n");
+}
+
+/**
+ * Discards the loaded results of the invariant whose connections differ from
+ * those of the EC with the same index now, so that an EC is only skipped if it
+ * is the very EC that was verified. Returns the number of discarded results.
+ */
+size_t Journal::discard_mismatched(
+    int inv_id,
+    const function<string(size_t)> &conns_of_ec) {
+    auto it = _invs.find(inv_id);
+    if (it == _invs.end()) {
+        return 0;
+    }
+
+    size_t num_discarded = 0;
+    auto &results = it->second.results;
+    for (auto res_it = results.begin(); res_it != results.end();) {
+        if (res_it->first >= it->second.num_ecs ||
+            res_it->second.conns != conns_of_ec(res_it->first)) {
+            res_it = results.erase(res_it);
+            ++num_discarded;
+        } else {
+            ++res_it;
+        }
+    }
+
+    if (num_discarded > 0) {
+        logger.warn("Discarded " + to_string(num_discarded) +
+                    " journaled results of invariant " + to_string(inv_id) +
+                    " whose connections have changed");
+    }
+    return num_discarded;
+}
+
+bool Journal::finished(int inv_id, size_t ec_idx) const {
+    auto it = _invs.find(inv_id);
+    return it != _invs.end() && it->second.results.count(ec_idx) > 0;
+}
+
+size_t Journal::num_finished(int inv_id) const {
+    auto it = _invs.find(inv_id);
+    return it == _invs.end() ? 0 : it->second.results.size();
+}
+
+bool Journal::violated(int inv_id) const {
+    auto it = _invs.find(inv_id);
+    if (it != _invs.end()) {
+        for (const auto &[_, res] : it->second.results) {
+            if (res.violated) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Journal::record(int inv_id, size_t ec_idx, const Result &res) const {
+    append("E " + to_string(inv_id) + " " + to_string(ec_idx) + " " +
+           (res.violated ? "1" : "0") + " " + to_string(res.time) + " " +
+           to_string(res.peak_rss) + " " + to_string(res.states_stored) + " " +
+           to_string(res.hash_conflicts) + " " + res.conns + "\n");
+}
+
+/**
+ * Records the result of an EC from another run, which marks the EC finished.
+ */
+void Journal::carry_over(int inv_id, size_t ec_idx, const Result &res) {
+    record(inv_id, ec_idx, res);
+    _invs[inv_id].results[ec_idx] = res;
+}
+
+/**
+ * Flushes the journal to disk, at most once per SYNC_INTERVAL unless forced.
+ */
+void Journal::sync(bool force) {
+    if (_fd < 0) {
+        return;
+    }
+
+    if (!force) {
+        const auto now = chrono::steady_clock::now();
+        if (now - _last_sync < SYNC_INTERVAL) {
+            return;
+        }
+        _last_sync = now;
+    }
+
+    fdatasync(_fd);
+}
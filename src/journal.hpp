@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+
+/**
+ * Journal is an append-only record of the finished connection ECs in the
+ * output directory, which allows a killed run to be resumed (`--resume`)
+ * without verifying the finished ECs again, and a later run to carry over the
+ * results of the unaffected ECs (`--baseline`).
+ *
+ * Each line is either the start of an invariant or the result of a connection
+ * EC:
+ *   I <invariant id> <number of connection ECs> <invariant>
+ *   E <invariant id> <EC index> <violated> <time (usec)> <peak memory (KiB)>
+ *     <states stored> <hash conflicts> <connections>
+ *
+ * The EC processes append their own results with a single write() each, which
+ * is atomic with O_APPEND and survives the process being killed. The invariant
+ * processes flush the journal to disk periodically and when they terminate, so
+ * that there is no fsync on the EC path.
+ */
+class Journal {
+public:
+    struct Result {
+        bool violated;
+        long long time; // usec
+        long peak_rss;  // KiB
+        long long states_stored;
+        long long hash_conflicts;
+        std::string conns; // connections of the EC (one line)
+    };
+    struct InvResults {
+        size_t num_ecs;
+        std::string inv;                  // description of the invariant
+        std::map<size_t, Result> results; // EC index -> result
+    };
+
+private:
+    int _fd;
+    std::map<int, InvResults> _invs; // entries loaded for resuming
+    std::chrono::steady_clock::time_point _last_sync;
+
+    void append(const std::string &line) const;
+
+public:
+    Journal();
+    Journal(const Journal &) = delete;
+    Journal(Journal &&) = delete;
+    ~Journal();
+    Journal &operator=(const Journal &) = delete;
+    Journal &operator=(Journal &&) = delete;
+
+    // Reads the entries of a journal, skipping the malformed lines
+    static std::map<int, InvResults> read(const std::filesystem::path &);
+
+    void open(const std::filesystem::path &out_dir, bool resume);
+    void reset();
+
+    void begin_invariant(int inv_id, size_t num_ecs, const std::string &inv);
+    size_t discard_mismatched(
+        int inv_id,
+        const std::function<std::string(size_t)> &conns_of_ec);
+    bool finished(int inv_id, size_t ec_idx) const;
+    size_t num_finished(int inv_id) const;
+    bool violated(int inv_id) const;
+    void record(int inv_id, size_t ec_idx, const Result &) const;
+    void carry_over(int inv_id, size_t ec_idx, const Result &);
+    void sync(bool force = false);
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A typed slab arena for objects that live until the arena is reset, such as
+ * the interned objects of UniqueStorage.
+ *
+ * Objects are bump-allocated from slabs of `slab_size` objects, so creating an
+ * object costs no malloc beyond the occasional slab, and the objects are never
+ * freed individually. reset() runs the destructors (skipped for trivially
+ * destructible types) and rewinds to the first slab, which is kept for reuse;
+ * the other slabs are released in bulk.
+ */
+template <class T, size_t slab_size = 1024>
+class Arena {
+private:
+    struct alignas(T) Slot {
+        std::byte bytes[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> _slabs;
+    size_t _used = slab_size; // number of objects in the last slab
+    size_t _size = 0;
+
+    T *at(size_t slab, size_t idx) const {
+        return std::launder(reinterpret_cast<T *>(_slabs[slab][idx].bytes));
+    }
+
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena(Arena &&) = delete;
+    ~Arena() { reset(); }
+    Arena &operator=(const Arena &) = delete;
+    Arena &operator=(Arena &&) = delete;
+
+    template <class... Args>
+    T *create(Args &&...args) {
+        if (_used == slab_size) {
+            const size_t next = _size / slab_size;
+            if (next == _slabs.size()) {
+                _slabs.emplace_back(new Slot[slab_size]);
+            }
+            _used = 0;
+        }
+
+        const size_t slab = _size / slab_size;
+        T *obj = new (_slabs[slab][_used].bytes) T(std::forward<Args>(args)...);
+        ++_used;
+        ++_size;
+        return obj;
+    }
+
+    size_t size() const { return _size; }
+
+    void reset() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < _size; ++i) {
+                at(i / slab_size, i % slab_size)->~T();
+            }
+        }
+
+        if (_slabs.size() > 1) {
+            _slabs.resize(1);
+        }
+        _used = slab_size;
+        _size = 0;
+    }
+};
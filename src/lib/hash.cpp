@@ -15,4 +15,18 @@ size_t &hash_combine(size_t &seed, size_t value) {
     return seed;
 }
 
+/**
+ * Finalizer of SplitMix64. The hashes of container entries are mixed before
+ * being summed up, so that the hash of the container can be updated entry by
+ * entry regardless of the order.
+ */
+size_t mix(size_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
 } // namespace hash
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <class T>
+class IDMap;
+
+/**
+ * Base of the objects that are referred to by dense 32-bit IDs in the Spin
+ * state vector, which keeps the ID assigned by IDMap in the object itself. The
+ * ID is not copied along with the object, since a copy is a different object
+ * (e.g., a candidate to be interned).
+ */
+class DenseID {
+private:
+    uint32_t _dense_id = 0;
+
+    template <class T>
+    friend class IDMap;
+
+public:
+    DenseID() = default;
+    DenseID(const DenseID &) {}
+    DenseID &operator=(const DenseID &) { return *this; }
+};
+
+/**
+ * IDMap assigns dense 32-bit IDs to objects, so that the objects can be
+ * referred to by 4-byte IDs instead of pointers in the Spin state vector. ID 0
+ * always refers to nullptr.
+ *
+ * The ID is stored in the object (see DenseID), so translating in either
+ * direction is a field read or a vector index. An ID is only trusted if it
+ * maps back to the same object, since the objects may outlive a clear() (e.g.,
+ * the network nodes), and a new object may reuse the address of a destroyed
+ * one. Objects without a valid ID are assigned one on first sight.
+ *
+ * Processes that compare state vectors with each other (e.g., the helpers of
+ * the native explorer, which share the visited states) draw new IDs from a
+ * counter in shared memory instead, so that an ID never refers to different
+ * objects in different processes. The IDs of a process are then sparse.
+ */
+template <class T>
+class IDMap {
+private:
+    std::vector<T *> _objs{nullptr};
+    std::atomic<uint32_t> *_next = nullptr; // shared ID counter
+
+public:
+    // Assigns a new ID to the object, e.g., when it is interned
+    uint32_t assign(T *obj) {
+        const uint32_t id =
+            _next ? _next->fetch_add(1, std::memory_order_relaxed)
+                  : _objs.size();
+        if (id >= _objs.size()) {
+            _objs.resize(id + 1, nullptr);
+        }
+        _objs[id] = obj;
+        obj->_dense_id = id;
+        return id;
+    }
+
+    // Draws the new IDs from the shared counter, which continues from ours
+    void share(std::atomic<uint32_t> *next) {
+        next->store(_objs.size(), std::memory_order_relaxed);
+        _next = next;
+    }
+    void unshare() { _next = nullptr; }
+
+    uint32_t id(T *obj) {
+        if (!obj) {
+            return 0;
+        }
+
+        const uint32_t id = obj->_dense_id;
+        if (id < _objs.size() && _objs[id] == obj) [[likely]] {
+            return id;
+        }
+        return assign(obj);
+    }
+
+    T *object(uint32_t id) const { return _objs[id]; }
+    size_t size() const { return _objs.size() - 1; } // highest ID
+
+    void clear() {
+        _objs.assign(1, nullptr);
+        _next = nullptr;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A flat open-addressing set of pointers to interned objects, for
+ * UniqueStorage.
+ *
+ * Like a Swiss table, a separate array of control bytes holds 7 bits of the
+ * hash of each occupied slot, so a probe mostly scans contiguous bytes and only
+ * compares the objects whose control bytes match. Each slot keeps the full hash
+ * of its object, which is computed once when the object is stored; it is
+ * compared before the objects and reused when the table grows. Interned objects
+ * are never erased individually, so there are no tombstones.
+ */
+template <class T, class Hash, class Eq>
+class InternTable {
+private:
+    static constexpr uint8_t empty = 0x80;
+
+    struct Slot {
+        size_t hash;
+        T *obj;
+    };
+
+    std::vector<uint8_t> _ctrl; // empty, or the top 7 bits of the mixed hash
+    std::vector<Slot> _slots;
+    size_t _size = 0;
+
+    static uint64_t mix(size_t hash) {
+        return uint64_t(hash) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    // Home slot of the mixed hash, whose top 7 bits go to the control byte
+    static size_t home(uint64_t h, size_t mask) {
+        return (h ^ (h >> 29)) & mask;
+    }
+
+    void grow() {
+        const size_t capacity = _slots.empty() ? 16 : _slots.size() * 2;
+        std::vector<uint8_t> ctrl(capacity, empty);
+        std::vector<Slot> slots(capacity);
+
+        for (size_t i = 0; i < _slots.size(); ++i) {
+            if (_ctrl[i] != empty) {
+                const uint64_t h = mix(_slots[i].hash);
+                size_t pos = home(h, capacity - 1);
+                while (ctrl[pos] != empty) {
+                    pos = (pos + 1) & (capacity - 1);
+                }
+                ctrl[pos] = h >> 57;
+                slots[pos] = _slots[i];
+            }
+        }
+
+        _ctrl.swap(ctrl);
+        _slots.swap(slots);
+    }
+
+public:
+    static size_t hash(T *obj) { return Hash()(obj); }
+
+    // Returns the stored object equal to obj, whose hash is given, or nullptr
+    T *find(T *obj, size_t hash) const {
+        if (_slots.empty()) {
+            return nullptr;
+        }
+
+        const uint64_t h = mix(hash);
+        const uint8_t h2 = h >> 57;
+        const size_t mask = _slots.size() - 1;
+
+        for (size_t pos = home(h, mask); _ctrl[pos] != empty;
+             pos = (pos + 1) & mask) {
+            if (_ctrl[pos] == h2 && _slots[pos].hash == hash &&
+                Eq()(_slots[pos].obj, obj)) {
+                return _slots[pos].obj;
+            }
+        }
+        return nullptr;
+    }
+
+    // Inserts an object that is not in the table yet
+    void insert(T *obj, size_t hash) {
+        // Max load factor: 7/8
+        if ((_size + 1) * 8 > _slots.size() * 7) {
+            grow();
+        }
+
+        const uint64_t h = mix(hash);
+        const size_t mask = _slots.size() - 1;
+        size_t pos = home(h, mask);
+        while (_ctrl[pos] != empty) {
+            pos = (pos + 1) & mask;
+        }
+        _ctrl[pos] = h >> 57;
+        _slots[pos] = {hash, obj};
+        ++_size;
+    }
+
+    size_t size() const { return _size; }
+
+    // Keeps the capacity for the next EC
+    void clear() {
+        std::fill(_ctrl.begin(), _ctrl.end(), empty);
+        _size = 0;
+    }
+};
@@ -0,0 +1,129 @@
+#include "lib/lpm-trie.hpp"
+
+#include <algorithm>
+#include <bit>
+
+using namespace std;
+
+namespace {
+
+inline uint32_t prefix_mask(int len) {
+    return len == 0 ? 0 : ~uint32_t(0) << (32 - len);
+}
+
+// The bit at the given position, counting from the most significant bit
+inline int bit_at(uint32_t addr, int pos) {
+    return (addr >> (31 - pos)) & 1;
+}
+
+inline int common_prefix_len(uint32_t a, uint32_t b, int max_len) {
+    return min(countl_zero(a ^ b), max_len);
+}
+
+} // namespace
+
+LPMTrie::LPMTrie() : _size(0) {
+    new_node(0, 0, false);
+}
+
+int32_t LPMTrie::new_node(uint32_t prefix, uint8_t len, bool present) {
+    _nodes.push_back({prefix, len, present, {-1, -1}});
+    return _nodes.size() - 1;
+}
+
+void LPMTrie::insert(const IPNetwork<IPv4Address> &net) {
+    const int len = net.prefix_length();
+    const uint32_t prefix = net.network_addr().get_value() & prefix_mask(len);
+    int32_t node = 0;
+
+    // Invariant: the prefix of `node` contains the inserted prefix.
+    while (_nodes[node].len < len) {
+        const int bit = bit_at(prefix, _nodes[node].len);
+        const int32_t child = _nodes[node].child[bit];
+
+        if (child < 0) {
+            int32_t leaf = new_node(prefix, len, true);
+            _nodes[node].child[bit] = leaf;
+            ++_size;
+            return;
+        }
+
+        const int common = common_prefix_len(prefix, _nodes[child].prefix,
+                                             min<int>(len, _nodes[child].len));
+        if (common == _nodes[child].len) {
+            node = child;
+            continue;
+        }
+
+        // Split the edge between `node` and `child`
+        int32_t mid;
+        if (common == len) {
+            mid = new_node(prefix, len, true);
+        } else {
+            mid = new_node(prefix & prefix_mask(common), common, false);
+            _nodes[mid].child[bit_at(prefix, common)] =
+                new_node(prefix, len, true);
+        }
+        _nodes[mid].child[bit_at(_nodes[child].prefix, common)] = child;
+        _nodes[node].child[bit] = mid;
+        ++_size;
+        return;
+    }
+
+    if (!_nodes[node].present) {
+        _nodes[node].present = true;
+        ++_size;
+    }
+}
+
+/**
+ * Erased prefixes are only unmarked. The trie shape is kept, as routing tables
+ * rarely shrink, and `clear` drops all the nodes anyway.
+ */
+void LPMTrie::erase(const IPNetwork<IPv4Address> &net) {
+    const int len = net.prefix_length();
+    const uint32_t prefix = net.network_addr().get_value() & prefix_mask(len);
+    int32_t node = 0;
+
+    while (node >= 0 && _nodes[node].len <= len &&
+           common_prefix_len(prefix, _nodes[node].prefix, _nodes[node].len) ==
+               _nodes[node].len) {
+        if (_nodes[node].len == len) {
+            if (_nodes[node].present) {
+                _nodes[node].present = false;
+                --_size;
+            }
+            return;
+        }
+        node = _nodes[node].child[bit_at(prefix, _nodes[node].len)];
+    }
+}
+
+void LPMTrie::clear() {
+    _nodes.clear();
+    _size = 0;
+    new_node(0, 0, false);
+}
+
+optional<IPNetwork<IPv4Address>>
+LPMTrie::lookup(const IPv4Address &addr) const {
+    const uint32_t value = addr.get_value();
+    int32_t node = 0, best = -1;
+
+    while (node >= 0 && (value & prefix_mask(_nodes[node].len)) ==
+                            _nodes[node].prefix) {
+        if (_nodes[node].present) {
+            best = node;
+        }
+        if (_nodes[node].len == 32) {
+            break;
+        }
+        node = _nodes[node].child[bit_at(value, _nodes[node].len)];
+    }
+
+    if (best < 0) {
+        return nullopt;
+    }
+    return IPNetwork<IPv4Address>(IPv4Address(_nodes[best].prefix),
+                                  _nodes[best].len);
+}
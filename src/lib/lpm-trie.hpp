@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "lib/ip.hpp"
+
+/**
+ * A path-compressed binary trie of IPv4 prefixes for longest prefix matching.
+ *
+ * Each node holds a prefix and the nodes only branch where the stored prefixes
+ * diverge, so a lookup visits at most (prefix length + 1) nodes, and usually
+ * far fewer. Nodes are kept in a vector and refer to each other by index, which
+ * makes the trie trivially copyable along with the owning routing table.
+ */
+class LPMTrie {
+private:
+    struct TrieNode {
+        uint32_t prefix;  // network address (host bits are zero)
+        uint8_t len;      // prefix length
+        bool present;     // whether the prefix itself is stored
+        int32_t child[2]; // children by the next bit (-1: none)
+    };
+
+    std::vector<TrieNode> _nodes; // _nodes[0] is the root (0.0.0.0/0)
+    size_t _size;                 // number of present prefixes
+
+    int32_t new_node(uint32_t prefix, uint8_t len, bool present);
+
+public:
+    LPMTrie();
+    LPMTrie(const LPMTrie &) = default;
+    LPMTrie(LPMTrie &&) = default;
+    LPMTrie &operator=(const LPMTrie &) = default;
+    LPMTrie &operator=(LPMTrie &&) = default;
+
+    void insert(const IPNetwork<IPv4Address> &);
+    void erase(const IPNetwork<IPv4Address> &);
+    void clear();
+    bool empty() const { return _size == 0; }
+    size_t size() const { return _size; }
+
+    // Returns the longest stored prefix that contains the address
+    std::optional<IPNetwork<IPv4Address>> lookup(const IPv4Address &) const;
+};
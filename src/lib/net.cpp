@@ -637,12 +637,9 @@ void Net::identify_conn(Packet &pkt) const {
         }
     }
 
-    // new connection (NAT'd packets are also treated as new connections)
+    // new connection (NAT'd packets are also treated as new connections). It
+    // may exceed the max number of connections, which is up to the caller.
     if (conn >= model.get_num_conns()) {
-        if (conn >= MAX_CONNS) {
-            logger.error("Exceeding the maximum number of connections");
-        }
-
         pkt.set_is_new(true);
         pkt.set_opposite_dir(false);
         pkt.set_conn(conn);
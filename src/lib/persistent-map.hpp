@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "lib/hash.hpp"
+
+/**
+ * A persistent hash map (a hash array mapped trie in the CHAMP layout), for the
+ * interned objects that are copied to change one entry, such as PacketHistory.
+ *
+ * Copying a map only copies the pointer to the root, and assigning an entry
+ * copies the O(log n) nodes along the path to it, sharing all the other nodes
+ * with the original map. Each node consumes 5 bits of the 64-bit key hash, and
+ * keeps its entries and its subnodes in two separate arrays indexed by
+ * bitmaps. Since entries are never erased, the shape of the trie only depends
+ * on the keys, so two maps are compared node by node, skipping the shared ones.
+ * Keys with the same full hash are kept sorted in a collision node.
+ */
+template <class K, class V, class Hash = std::hash<K>>
+class PersistentMap {
+private:
+    static constexpr int bits = 5;
+    static constexpr int max_shift = 64;
+
+    struct Entry {
+        uint64_t hash;
+        K key;
+        V value;
+    };
+
+    struct Node {
+        uint32_t datamap = 0; // slots holding an entry
+        uint32_t nodemap = 0; // slots holding a subnode
+        std::vector<Entry> entries;
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+
+    std::shared_ptr<const Node> _root;
+    size_t _size = 0;
+
+    static uint32_t slot(uint64_t hash, int shift) {
+        return uint32_t(1) << ((hash >> shift) & ((1 << bits) - 1));
+    }
+
+    static size_t index(uint32_t bitmap, uint32_t bit) {
+        return std::popcount(bitmap & (bit - 1));
+    }
+
+    static bool is_collision(int shift) { return shift >= max_shift; }
+
+    // Returns a node holding the two entries, which share the hash bits
+    // before the shift
+    static std::shared_ptr<const Node>
+    merge(Entry &&a, Entry &&b, int shift) {
+        auto node = std::make_shared<Node>();
+
+        if (is_collision(shift)) {
+            if (b.key < a.key) {
+                std::swap(a, b);
+            }
+            node->entries.push_back(std::move(a));
+            node->entries.push_back(std::move(b));
+            return node;
+        }
+
+        const uint32_t bit_a = slot(a.hash, shift), bit_b = slot(b.hash, shift);
+        if (bit_a == bit_b) {
+            node->nodemap = bit_a;
+            node->children.push_back(
+                merge(std::move(a), std::move(b), shift + bits));
+        } else {
+            node->datamap = bit_a | bit_b;
+            if (bit_b < bit_a) {
+                std::swap(a, b);
+            }
+            node->entries.push_back(std::move(a));
+            node->entries.push_back(std::move(b));
+        }
+        return node;
+    }
+
+    // Returns the copy of the node with the entry assigned
+    static std::shared_ptr<const Node> assign(const Node *node,
+                                              Entry &&entry,
+                                              int shift,
+                                              bool &inserted) {
+        auto copy = std::make_shared<Node>(*node);
+
+        if (is_collision(shift)) {
+            auto it = std::lower_bound(
+                copy->entries.begin(), copy->entries.end(), entry.key,
+                [](const Entry &e, const K &key) { return e.key < key; });
+            if (it != copy->entries.end() && !(entry.key < it->key)) {
+                it->value = std::move(entry.value);
+            } else {
+                copy->entries.insert(it, std::move(entry));
+                inserted = true;
+            }
+            return copy;
+        }
+
+        const uint32_t bit = slot(entry.hash, shift);
+        if (copy->datamap & bit) {
+            const size_t i = index(copy->datamap, bit);
+            Entry &existing = copy->entries[i];
+            if (existing.hash == entry.hash && existing.key == entry.key) {
+                existing.value = std::move(entry.value);
+                return copy;
+            }
+
+            // Push both entries down to a new subnode
+            auto child =
+                merge(std::move(existing), std::move(entry), shift + bits);
+            copy->entries.erase(copy->entries.begin() + i);
+            copy->datamap &= ~bit;
+            copy->nodemap |= bit;
+            copy->children.insert(
+                copy->children.begin() + index(copy->nodemap, bit), child);
+            inserted = true;
+        } else if (copy->nodemap & bit) {
+            auto &child = copy->children[index(copy->nodemap, bit)];
+            child =
+                assign(child.get(), std::move(entry), shift + bits, inserted);
+        } else {
+            copy->datamap |= bit;
+            copy->entries.insert(
+                copy->entries.begin() + index(copy->datamap, bit),
+                std::move(entry));
+            inserted = true;
+        }
+        return copy;
+    }
+
+    static bool equal(const Node *a, const Node *b) {
+        if (a == b) {
+            return true;
+        }
+        if (a->datamap != b->datamap || a->nodemap != b->nodemap ||
+            a->entries.size() != b->entries.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a->entries.size(); ++i) {
+            if (!(a->entries[i].key == b->entries[i].key) ||
+                !(a->entries[i].value == b->entries[i].value)) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < a->children.size(); ++i) {
+            if (!equal(a->children[i].get(), b->children[i].get())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <class F>
+    static void for_each(const Node *node, F &f) {
+        for (const Entry &entry : node->entries) {
+            f(entry.key, entry.value);
+        }
+        for (const auto &child : node->children) {
+            for_each(child.get(), f);
+        }
+    }
+
+public:
+    static uint64_t hash(const K &key) { return ::hash::mix(Hash()(key)); }
+
+    // Returns the value of the key, or nullptr if the key is not in the map
+    const V *find(const K &key) const {
+        const uint64_t h = hash(key);
+        const Node *node = _root.get();
+
+        for (int shift = 0; node; shift += bits) {
+            if (is_collision(shift)) {
+                for (const Entry &entry : node->entries) {
+                    if (entry.key == key) {
+                        return &entry.value;
+                    }
+                }
+                return nullptr;
+            }
+
+            const uint32_t bit = slot(h, shift);
+            if (node->datamap & bit) {
+                const Entry &entry = node->entries[index(node->datamap, bit)];
+                return entry.hash == h && entry.key == key ? &entry.value
+                                                           : nullptr;
+            } else if (node->nodemap & bit) {
+                node = node->children[index(node->nodemap, bit)].get();
+            } else {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    // Returns true if the key is new to the map
+    bool assign(const K &key, V value) {
+        static const Node empty;
+        bool inserted = false;
+        _root = assign(_root ? _root.get() : &empty,
+                       Entry{hash(key), key, std::move(value)}, 0, inserted);
+        _size += inserted;
+        return inserted;
+    }
+
+    size_t size() const { return _size; }
+
+    // Calls f(key, value) for every entry, in the order of the trie
+    template <class F>
+    void for_each(F f) const {
+        if (_root) {
+            for_each(_root.get(), f);
+        }
+    }
+
+    bool operator==(const PersistentMap &other) const {
+        if (_size != other._size) {
+            return false;
+        }
+        if (!_root || !other._root) {
+            return !_root && !other._root;
+        }
+        return equal(_root.get(), other._root.get());
+    }
+};
@@ -0,0 +1,168 @@
+#include "lib/state-set.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+
+#include "lib/hash.hpp"
+#include "logger.hpp"
+
+using namespace std;
+
+// Bytes reserved for the header, keeping the slots on their own cache lines
+#define HEADER_SIZE 64
+
+StateSet::StateSet() :
+    _mem(nullptr),
+    _mem_size(0),
+    _header(nullptr),
+    _slots(nullptr),
+    _entries(nullptr),
+    _mask(0),
+    _state_size(0),
+    _entry_size(0),
+    _compact(false) {}
+
+StateSet::~StateSet() {
+    reset();
+}
+
+static size_t entry_size(size_t state_size) {
+    // Keep the entries 8-byte aligned for their hashes
+    return (sizeof(uint64_t) + state_size + 7) & ~size_t(7);
+}
+
+size_t StateSet::num_slots(size_t mem, size_t state_size, bool compact) {
+    // One slot per state that can be stored within the budget
+    const size_t per_state =
+        sizeof(uint64_t) + (compact ? 0 : entry_size(state_size));
+    return bit_floor(max(mem / per_state, size_t(1) << 10));
+}
+
+void StateSet::init(size_t num_slots, size_t state_size, bool compact) {
+    static_assert(sizeof(Header) <= HEADER_SIZE);
+    if (!has_single_bit(num_slots)) {
+        logger.error("Invalid number of slots " + to_string(num_slots));
+    }
+
+    const size_t esize = entry_size(state_size);
+    const size_t mem_size = HEADER_SIZE + num_slots * sizeof(uint64_t) +
+                            (compact ? 0 : num_slots * esize);
+
+    // Reuse the mapping of the same size, which only needs to be emptied
+    if (_mem && _mem_size == mem_size) {
+        clear();
+    } else {
+        reset();
+        void *addr = mmap(nullptr, mem_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (addr == MAP_FAILED) {
+            logger.error("mmap()", errno);
+        }
+        _mem = addr;
+        _mem_size = mem_size;
+    }
+
+    // Anonymous pages are zero-filled, i.e., all slots are empty
+    unsigned char *mem = static_cast<unsigned char *>(_mem);
+    _header = reinterpret_cast<Header *>(mem);
+    _slots = reinterpret_cast<atomic<uint64_t> *>(mem + HEADER_SIZE);
+    _entries =
+        compact ? nullptr : mem + HEADER_SIZE + num_slots * sizeof(uint64_t);
+    _mask = num_slots - 1;
+    _state_size = state_size;
+    _entry_size = esize;
+    _compact = compact;
+}
+
+/**
+ * Empties the set by releasing the pages of the mapping, which are zero-filled
+ * again when touched. MADV_DONTNEED would only drop our page table entries of a
+ * shared mapping, keeping its contents.
+ */
+void StateSet::clear() {
+    if (_mem && madvise(_mem, _mem_size, MADV_REMOVE) != 0) {
+        logger.error("madvise()", errno);
+    }
+}
+
+void StateSet::reset() {
+    if (_mem) {
+        munmap(_mem, _mem_size);
+    }
+
+    _mem = nullptr;
+    _mem_size = 0;
+    _header = nullptr;
+    _slots = nullptr;
+    _entries = nullptr;
+    _mask = 0;
+    _state_size = 0;
+    _entry_size = 0;
+    _compact = false;
+}
+
+StateSet::Entry *StateSet::entry(uint64_t slot) const {
+    return reinterpret_cast<Entry *>(_entries + (slot - 1) * _entry_size);
+}
+
+bool StateSet::insert(const void *state) {
+    uint64_t hash = ::hash::hash(state, _state_size);
+    hash = hash ? hash : 1;
+    uint64_t value = _compact ? hash : 0; // slot value of the state
+
+    for (size_t i = hash & _mask, probes = 0; probes <= _mask;
+         i = (i + 1) & _mask, ++probes) {
+        uint64_t slot = _slots[i].load(memory_order_acquire);
+
+        if (slot == 0) {
+            if (value == 0) {
+                // Store a copy of the state, published by the CAS below. It is
+                // wasted if another process inserts the same state first.
+                const size_t idx =
+                    _header->entries.fetch_add(1, memory_order_relaxed);
+                if (idx > _mask) {
+                    break;
+                }
+                value = idx + 1;
+                Entry *stored = entry(value);
+                stored->hash = hash;
+                memcpy(stored->state, state, _state_size);
+            }
+
+            if (_slots[i].compare_exchange_strong(slot, value,
+                                                  memory_order_acq_rel)) {
+                _header->size.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+            // `slot` now holds the value inserted by someone else
+        }
+
+        if (_compact) {
+            if (slot == hash) {
+                return false;
+            }
+        } else {
+            const Entry *stored = entry(slot);
+            if (stored->hash == hash &&
+                memcmp(stored->state, state, _state_size) == 0) {
+                return false;
+            }
+        }
+
+        _header->conflicts.fetch_add(1, memory_order_relaxed);
+    }
+
+    logger.error("Visited state table is full");
+    return false;
+}
+
+size_t StateSet::size() const {
+    return _header ? _header->size.load(memory_order_relaxed) : 0;
+}
+
+size_t StateSet::conflicts() const {
+    return _header ? _header->conflicts.load(memory_order_relaxed) : 0;
+}
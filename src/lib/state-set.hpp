@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A lock-free set of fixed-size state vectors for the native explorer, shared
+ * by all the processes forked after it is initialized.
+ *
+ * The set is an open-addressing table with linear probing. Each slot holds
+ * either the index of a stored copy of the state (exact mode) or a 64-bit
+ * fingerprint of the state (compact mode, like Spin's hash-compact storage).
+ * Slots are claimed with a single CAS, so concurrent inserters never block each
+ * other. The slots, the stored states, and the counters live in one shared
+ * anonymous mapping, which is never resized; it is sized up front from the
+ * memory budget, and its pages are only backed by memory once touched.
+ */
+class StateSet {
+private:
+    struct Entry {
+        uint64_t hash;
+        unsigned char state[]; // _state_size bytes
+    };
+
+    // Counters at the start of the mapping
+    struct Header {
+        std::atomic<size_t> size;
+        std::atomic<size_t> conflicts; // probes past an occupied slot
+        std::atomic<size_t> entries;   // allocated entries (exact mode)
+    };
+
+    void *_mem;                    // shared mapping
+    size_t _mem_size;              // bytes of the mapping
+    Header *_header;               // counters
+    std::atomic<uint64_t> *_slots; // 0: empty slot
+    unsigned char *_entries;       // stored states (exact mode)
+    size_t _mask;                  // number of slots - 1
+    size_t _state_size;            // bytes per state vector
+    size_t _entry_size;            // bytes per stored state (exact mode)
+    bool _compact;                 // fingerprints only, no exact comparison
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    Entry *entry(uint64_t slot) const;
+
+public:
+    StateSet();
+    StateSet(const StateSet &) = delete;
+    StateSet(StateSet &&) = delete;
+    ~StateSet();
+    StateSet &operator=(const StateSet &) = delete;
+    StateSet &operator=(StateSet &&) = delete;
+
+    // Number of slots (a power of 2) that fit in the memory budget
+    static size_t num_slots(size_t mem, size_t state_size, bool compact);
+
+    void init(size_t num_slots, size_t state_size, bool compact);
+    void clear();
+    void reset();
+
+    // Returns true if the state was not in the set
+    bool insert(const void *state);
+    size_t size() const;
+    size_t conflicts() const;
+};
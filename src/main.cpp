@@ -1,6 +1,7 @@
 #include <exception>
 #include <filesystem>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include <boost/program_options.hpp>
@@ -16,20 +17,75 @@ int main(int argc, char **argv) {
     desc.add_options()("help,h", "Show help message");
     desc.add_options()("all,a", "Verify all ECs after violation");
     desc.add_options()("force,f", "Remove output dir if exists");
+    desc.add_options()(
+        "resume,r",
+        "Resume a killed run in the output dir, skipping the connection ECs "
+        "finished according to its journal");
     desc.add_options()(
         "parallel-invs,p",
         "Allow verifying invariants in parallel (default: disabled). This is "
         "mostly used for narrow invariants who only have one EC to check.");
+    desc.add_options()(
+        "enable-por",
+        "Enable partial-order reduction of connection interleavings, which "
+        "assumes that middleboxes don't rewrite or redirect packets, unlike "
+        "NATs and load balancers (default: disabled)");
+    desc.add_options()(
+        "symmetry",
+        "Verify one representative of each group of symmetric connections");
+    desc.add_options()(
+        "prioritize",
+        "Verify the connection ECs that are more likely to violate the "
+        "invariant first");
+    desc.add_options()(
+        "swarm", po::value<size_t>()->default_value(1),
+        "Number of diversified searches per connection EC, where the first "
+        "counterexample wins [default: 1]");
+    desc.add_options()(
+        "sample", po::value<size_t>()->default_value(0),
+        "Verify a stratified random sample of N connection ECs per invariant "
+        "(implies -a), and report a confidence bound on the violation rate");
+    desc.add_options()(
+        "sample-fraction", po::value<double>()->default_value(0),
+        "Like --sample, with a fraction of the connection ECs per invariant");
+    desc.add_options()(
+        "shard", po::value<string>()->default_value("1/1"),
+        "Only verify the k-th of n disjoint shards of the connection ECs (k/n), "
+        "for splitting a run across independent processes");
+    desc.add_options()(
+        "plan",
+        "Estimate the verification workload without verifying, and write it "
+        "to plan.json in the output directory");
     desc.add_options()("jobs,j", po::value<size_t>()->default_value(1),
                        "Max number of parallel tasks [default: 1]");
+    desc.add_options()(
+        "adaptive-jobs",
+        "Adapt the number of parallel tasks to the CPU, memory, and injection "
+        "latency, up to --jobs (default: disabled)");
+    desc.add_options()("min-jobs", po::value<size_t>()->default_value(1),
+                       "Min number of parallel tasks with --adaptive-jobs");
     desc.add_options()("emulations,e", po::value<size_t>()->default_value(0),
                        "Max number of emulations");
     desc.add_options()("drop,d", po::value<string>()->default_value("timeout"),
                        "Drop detection method: ['timeout', 'dropmon', 'ebpf']");
+    desc.add_options()(
+        "search-mode,s", po::value<string>()->default_value("exhaustive"),
+        "Spin state storage mode: ['exhaustive', 'collapse', 'hashcompact', "
+        "'bitstate']");
+    desc.add_options()("engine", po::value<string>()->default_value("spin"),
+                       "State-space exploration engine: ['spin', 'native']");
     desc.add_options()("input,i", po::value<string>()->default_value(""),
                        "Input configuration file");
     desc.add_options()("output,o", po::value<string>()->default_value(""),
                        "Output directory");
+    desc.add_options()(
+        "cache-dir,c", po::value<string>()->default_value(""),
+        "Directory for persisting injection results and model variants across "
+        "runs (default: disabled)");
+    desc.add_options()(
+        "baseline,b", po::value<string>()->default_value(""),
+        "Output directory of a previous run, whose results are carried over "
+        "for the connection ECs unaffected by the changes since");
     po::variables_map vm;
 
     try {
@@ -47,23 +103,69 @@ int main(int argc, char **argv) {
 
     bool all_ecs = vm.count("all");
     bool rm_out_dir = vm.count("force");
+    bool resume = vm.count("resume");
     bool parallel_invs = vm.count("parallel-invs");
+    bool por = vm.count("enable-por");
+    bool symmetry = vm.count("symmetry");
+    bool prioritize = vm.count("prioritize");
+    size_t swarm = vm.at("swarm").as<size_t>();
+    size_t sample = vm.at("sample").as<size_t>();
+    double sample_fraction = vm.at("sample-fraction").as<double>();
+    string shard = vm.at("shard").as<string>();
+    bool plan = vm.count("plan");
     size_t max_jobs = vm.at("jobs").as<size_t>();
+    bool adaptive_jobs = vm.count("adaptive-jobs");
+    size_t min_jobs = vm.at("min-jobs").as<size_t>();
     size_t max_emu = vm.at("emulations").as<size_t>();
     string drop = vm.at("drop").as<string>();
+    string search_mode = vm.at("search-mode").as<string>();
+    string engine = vm.at("engine").as<string>();
     string input_file = vm.at("input").as<string>();
     string output_dir = vm.at("output").as<string>();
+    string cache_dir = vm.at("cache-dir").as<string>();
+    string baseline_dir = vm.at("baseline").as<string>();
 
-    if (max_jobs < 1) {
+    if (max_jobs < 1 || min_jobs < 1 || min_jobs > max_jobs) {
         cerr << "Invalid number of parallel tasks" << endl;
         return 1;
     }
 
+    if (swarm < 1) {
+        cerr << "Invalid number of swarm searches" << endl;
+        return 1;
+    }
+
+    if (sample_fraction < 0 || sample_fraction > 1 ||
+        (sample > 0 && sample_fraction > 0)) {
+        cerr << "Invalid sample size" << endl;
+        return 1;
+    }
+
+    size_t shard_idx = 0, num_shards = 0;
+    char slash = 0;
+    istringstream shard_iss(shard);
+    if (!(shard_iss >> shard_idx >> slash >> num_shards) || slash != '/' ||
+        !shard_iss.eof() || shard_idx < 1 || shard_idx > num_shards) {
+        cerr << "Invalid shard " << shard << endl;
+        return 1;
+    }
+
     if (drop != "timeout" && drop != "dropmon" && drop != "ebpf") {
         cerr << "Invalid drop detection method" << endl;
         return 1;
     }
 
+    if (search_mode != "exhaustive" && search_mode != "collapse" &&
+        search_mode != "hashcompact" && search_mode != "bitstate") {
+        cerr << "Invalid search mode" << endl;
+        return 1;
+    }
+
+    if (engine != "spin" && engine != "native") {
+        cerr << "Invalid engine" << endl;
+        return 1;
+    }
+
     if (input_file.empty() || !fs::exists(input_file)) {
         cerr << "Missing input file " << input_file << endl;
         return 1;
@@ -74,12 +176,46 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (rm_out_dir && resume) {
+        cerr << "--force and --resume are mutually exclusive" << endl;
+        return 1;
+    }
+
+    if (!baseline_dir.empty() &&
+        (!fs::exists(baseline_dir) ||
+         (fs::exists(output_dir) && fs::equivalent(baseline_dir, output_dir)))) {
+        cerr << "Invalid baseline directory " << baseline_dir << endl;
+        return 1;
+    }
+
     if (rm_out_dir && fs::exists(output_dir)) {
         fs::remove_all(output_dir);
     }
 
     Plankton &plankton = Plankton::get();
-    plankton.init(all_ecs, parallel_invs, max_jobs, max_emu, drop, input_file,
-                  output_dir);
-    return plankton.run();
+    PlanktonOptions opts;
+    opts.all_ecs = all_ecs;
+    opts.resume = resume;
+    opts.parallel_invs = parallel_invs;
+    opts.por = por;
+    opts.symmetry = symmetry;
+    opts.prioritize = prioritize;
+    opts.swarm = swarm;
+    opts.sample = sample;
+    opts.sample_fraction = sample_fraction;
+    opts.shard = shard_idx - 1;
+    opts.num_shards = num_shards;
+    opts.max_jobs = max_jobs;
+    opts.adaptive_jobs = adaptive_jobs;
+    opts.min_jobs = min_jobs;
+    opts.max_emu = max_emu;
+    opts.drop_method = drop;
+    opts.search_mode = search_mode;
+    opts.engine = engine;
+    opts.input_file = input_file;
+    opts.output_dir = output_dir;
+    opts.cache_dir = cache_dir;
+    opts.baseline_dir = baseline_dir;
+    plankton.init(opts);
+    return plan ? plankton.plan() : plankton.run();
 }
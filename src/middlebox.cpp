@@ -50,9 +50,7 @@ InjectionResults Middlebox::send_pkt(const Packet &pkt) {
     // using a vector should be more performant.
     InjectionResults results;
     for (int i = 0; i < _packets_per_injection; ++i) {
-        InjectionResult *ir = new InjectionResult(_emulation->send_pkt(pkt));
-        ir = storage.store_injection_result(ir);
-        results.add(ir);
+        results.add(storage.store_injection_result(_emulation->send_pkt(pkt)));
     }
 
     logger.info("Got " + std::to_string(results.size()) +
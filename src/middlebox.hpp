@@ -23,6 +23,8 @@ protected:
     int _packets_per_injection = 0;
     // The actual emulation instance
     Emulation *_emulation = nullptr;
+    // Digest of the image and configurations that determine the behavior
+    size_t _config_digest = 0;
 
     // Interesting IP and port values parsed from the config files
     std::set<IPNetwork<IPv4Address>> _ec_ip_prefixes;
@@ -47,6 +49,7 @@ public:
         return _packets_per_injection;
     }
     decltype(_emulation) emulation() const { return _emulation; }
+    decltype(_config_digest) config_digest() const { return _config_digest; }
     const decltype(_ec_ip_prefixes) &ec_ip_prefixes() const {
         return _ec_ip_prefixes;
     }
@@ -1,13 +1,14 @@
 #include "model-access.hpp"
 
 #include <cassert>
-#include <cstring>
+#include <string>
 #include <utility>
 
 #include "candidates.hpp"
 #include "choices.hpp"
 #include "eqclass.hpp"
 #include "fib.hpp"
+#include "fibmgr.hpp"
 #include "injection-result.hpp"
 #include "interface.hpp"
 #include "invariant/loadbalance.hpp"
@@ -22,11 +23,11 @@
 #include "reachcounts.hpp"
 #include "unique-storage.hpp"
 
-#include "model.h"
-
 Model &model = Model::get();
 
-Model::Model() : state(nullptr), network(nullptr), openflow(nullptr) {}
+Model::Model() :
+    state(nullptr), variant(neo_model_variant()), network(nullptr),
+    openflow(nullptr) {}
 
 Model &Model::get() {
     static Model instance;
@@ -41,6 +42,24 @@ void Model::set_state(State *state) {
     }
 }
 
+/**
+ * Binds the state vector to access. Unlike Spin's `now`, the states of the
+ * native explorer are at a different address for each search depth, so they
+ * are rebound whenever the current state changes.
+ */
+void Model::bind_state(State *state) {
+    this->state = state;
+}
+
+/**
+ * Switches to a model variant loaded by ModelMgr. This must be done before any
+ * Spin run, as the state vector layout differs between variants.
+ */
+void Model::set_variant(const model_variant *variant) {
+    this->state = nullptr;
+    this->variant = variant;
+}
+
 void Model::init(Network *network, OpenflowProcess *openflow) {
     this->network = network;
     this->openflow = openflow;
@@ -48,8 +67,10 @@ void Model::init(Network *network, OpenflowProcess *openflow) {
 
 void Model::reset() {
     state = nullptr;
+    variant = neo_model_variant();
     network = nullptr;
     openflow = nullptr;
+    std::apply([](auto &...id_maps) { (id_maps.clear(), ...); }, ids);
 }
 
 void Model::print_conn_states() const {
@@ -74,244 +95,279 @@ void Model::print_conn_states() const {
     set_conn(orig_conn);
 }
 
+/**
+ * The state variables are accessed through the accessors of the model variant.
+ * Reading a variable that isn't in the variant gives 0 (nullptr for IDs), while
+ * writing to it is an error.
+ */
+
+uint32_t Model::conn_var(int conn, model_conn_var idx) const {
+    auto get = variant->get_conn_var[idx];
+    return get ? get(state, conn) : 0;
+}
+
+uint32_t Model::conn_var(model_conn_var idx) const {
+    return conn_var(get_conn(), idx);
+}
+
+void Model::set_conn_var(model_conn_var idx, uint32_t value) const {
+    auto set = variant->set_conn_var[idx];
+    if (!set) {
+        logger.error("Connection state variable " + std::to_string(idx) +
+                     " isn't in the model variant");
+    }
+    set(state, get_conn(), value);
+}
+
+uint32_t Model::var(model_var idx) const {
+    auto get = variant->get_var[idx];
+    return get ? get(state) : 0;
+}
+
+void Model::set_var(model_var idx, uint32_t value) const {
+    auto set = variant->set_var[idx];
+    if (!set) {
+        logger.error("State variable " + std::to_string(idx) +
+                     " isn't in the model variant");
+    }
+    set(state, value);
+}
+
+int Model::get_max_conns() const {
+    return variant->max_conns;
+}
+
 int Model::get_executable() const {
-    return state->conn_state[state->conn].executable;
+    return conn_var(CONN_VAR_EXECUTABLE);
 }
 
 int Model::get_executable_for_conn(int conn) const {
-    return state->conn_state[conn].executable;
+    return conn_var(conn, CONN_VAR_EXECUTABLE);
 }
 
 int Model::set_executable(int executable) const {
-    return (state->conn_state[state->conn].executable = executable);
+    set_conn_var(CONN_VAR_EXECUTABLE, executable);
+    return executable;
 }
 
 uint16_t Model::get_proto_state() const {
-    return state->conn_state[state->conn].proto_state;
+    return conn_var(CONN_VAR_PROTO_STATE);
 }
 
 uint16_t Model::get_proto_state_for_conn(int conn) const {
-    return state->conn_state[conn].proto_state;
+    return conn_var(conn, CONN_VAR_PROTO_STATE);
 }
 
 uint16_t Model::set_proto_state(int proto_state) const {
-    return state->conn_state[state->conn].proto_state = proto_state;
+    set_conn_var(CONN_VAR_PROTO_STATE, proto_state);
+    return proto_state;
 }
 
 uint32_t Model::get_src_ip() const {
-    uint32_t src_ip;
-    memcpy(&src_ip, state->conn_state[state->conn].src_ip, sizeof(uint32_t));
-    return src_ip;
+    return conn_var(CONN_VAR_SRC_IP);
+}
+
+uint32_t Model::get_src_ip_for_conn(int conn) const {
+    return conn_var(conn, CONN_VAR_SRC_IP);
 }
 
 uint32_t Model::set_src_ip(uint32_t src_ip) const {
-    memcpy(state->conn_state[state->conn].src_ip, &src_ip, sizeof(uint32_t));
+    set_conn_var(CONN_VAR_SRC_IP, src_ip);
     return src_ip;
 }
 
 EqClass *Model::get_dst_ip_ec() const {
-    EqClass *dst_ip_ec;
-    memcpy(&dst_ip_ec, state->conn_state[state->conn].dst_ip_ec,
-           sizeof(EqClass *));
-    return dst_ip_ec;
+    return object<EqClass>(conn_var(CONN_VAR_DST_IP_EC));
 }
 
 EqClass *Model::set_dst_ip_ec(EqClass *dst_ip_ec) const {
-    memcpy(state->conn_state[state->conn].dst_ip_ec, &dst_ip_ec,
-           sizeof(EqClass *));
+    set_conn_var(CONN_VAR_DST_IP_EC, id(dst_ip_ec));
     return dst_ip_ec;
 }
 
 uint16_t Model::get_src_port() const {
-    return state->conn_state[state->conn].src_port;
+    return conn_var(CONN_VAR_SRC_PORT);
 }
 
 uint16_t Model::set_src_port(uint16_t src_port) const {
-    return state->conn_state[state->conn].src_port = src_port;
+    set_conn_var(CONN_VAR_SRC_PORT, src_port);
+    return src_port;
 }
 
 uint16_t Model::get_dst_port() const {
-    return state->conn_state[state->conn].dst_port;
+    return conn_var(CONN_VAR_DST_PORT);
 }
 
 uint16_t Model::set_dst_port(uint16_t dst_port) const {
-    return state->conn_state[state->conn].dst_port = dst_port;
+    set_conn_var(CONN_VAR_DST_PORT, dst_port);
+    return dst_port;
 }
 
 uint32_t Model::get_seq() const {
-    uint32_t seq;
-    memcpy(&seq, state->conn_state[state->conn].seq, sizeof(uint32_t));
-    return seq;
+    return conn_var(CONN_VAR_SEQ);
 }
 
 uint32_t Model::set_seq(uint32_t seq) const {
-    memcpy(state->conn_state[state->conn].seq, &seq, sizeof(uint32_t));
+    set_conn_var(CONN_VAR_SEQ, seq);
     return seq;
 }
 
 uint32_t Model::get_ack() const {
-    uint32_t ack;
-    memcpy(&ack, state->conn_state[state->conn].ack, sizeof(uint32_t));
-    return ack;
+    return conn_var(CONN_VAR_ACK);
 }
 
 uint32_t Model::set_ack(uint32_t ack) const {
-    memcpy(state->conn_state[state->conn].ack, &ack, sizeof(uint32_t));
+    set_conn_var(CONN_VAR_ACK, ack);
     return ack;
 }
 
 Payload *Model::get_payload() const {
-    Payload *payload;
-    memcpy(&payload, state->conn_state[state->conn].payload, sizeof(Payload *));
-    return payload;
+    return object<Payload>(conn_var(CONN_VAR_PAYLOAD));
 }
 
 Payload *Model::set_payload(Payload *payload) const {
-    memcpy(state->conn_state[state->conn].payload, &payload, sizeof(Payload *));
+    set_conn_var(CONN_VAR_PAYLOAD, id(payload));
     return payload;
 }
 
 Node *Model::get_src_node() const {
-    Node *src_node;
-    memcpy(&src_node, state->conn_state[state->conn].src_node, sizeof(Node *));
-    return src_node;
+    return object<Node>(conn_var(CONN_VAR_SRC_NODE));
 }
 
 Node *Model::set_src_node(Node *src_node) const {
-    memcpy(state->conn_state[state->conn].src_node, &src_node, sizeof(Node *));
+    set_conn_var(CONN_VAR_SRC_NODE, id(src_node));
     return src_node;
 }
 
 Node *Model::get_tx_node() const {
-    Node *tx_node;
-    memcpy(&tx_node, state->conn_state[state->conn].tx_node, sizeof(Node *));
-    return tx_node;
+    return object<Node>(conn_var(CONN_VAR_TX_NODE));
 }
 
 Node *Model::set_tx_node(Node *tx_node) const {
-    memcpy(state->conn_state[state->conn].tx_node, &tx_node, sizeof(Node *));
+    set_conn_var(CONN_VAR_TX_NODE, id(tx_node));
     return tx_node;
 }
 
 Node *Model::get_rx_node() const {
-    Node *rx_node;
-    memcpy(&rx_node, state->conn_state[state->conn].rx_node, sizeof(Node *));
-    return rx_node;
+    return object<Node>(conn_var(CONN_VAR_RX_NODE));
 }
 
 Node *Model::set_rx_node(Node *rx_node) const {
-    memcpy(state->conn_state[state->conn].rx_node, &rx_node, sizeof(Node *));
+    set_conn_var(CONN_VAR_RX_NODE, id(rx_node));
     return rx_node;
 }
 
 int Model::get_fwd_mode() const {
-    return state->conn_state[state->conn].fwd_mode;
+    return conn_var(CONN_VAR_FWD_MODE);
 }
 
 int Model::get_fwd_mode_for_conn(int conn) const {
-    return state->conn_state[conn].fwd_mode;
+    return conn_var(conn, CONN_VAR_FWD_MODE);
 }
 
 int Model::set_fwd_mode(int fwd_mode) const {
-    return state->conn_state[state->conn].fwd_mode = fwd_mode;
+    set_conn_var(CONN_VAR_FWD_MODE, fwd_mode);
+    return fwd_mode;
 }
 
 Node *Model::get_pkt_location() const {
-    Node *pkt_location;
-    memcpy(&pkt_location, state->conn_state[state->conn].pkt_location,
-           sizeof(Node *));
-    return pkt_location;
+    return object<Node>(conn_var(CONN_VAR_PKT_LOCATION));
+}
+
+Node *Model::get_pkt_location_for_conn(int conn) const {
+    return object<Node>(conn_var(conn, CONN_VAR_PKT_LOCATION));
 }
 
 Node *Model::set_pkt_location(Node *pkt_location) const {
-    memcpy(state->conn_state[state->conn].pkt_location, &pkt_location,
-           sizeof(Node *));
+    set_conn_var(CONN_VAR_PKT_LOCATION, id(pkt_location));
     return pkt_location;
 }
 
 Interface *Model::get_ingress_intf() const {
-    Interface *ingress_intf;
-    memcpy(&ingress_intf, state->conn_state[state->conn].ingress_intf,
-           sizeof(Interface *));
-    return ingress_intf;
+    return object<Interface>(conn_var(CONN_VAR_INGRESS_INTF));
 }
 
 Interface *Model::set_ingress_intf(Interface *ingress_intf) const {
-    memcpy(state->conn_state[state->conn].ingress_intf, &ingress_intf,
-           sizeof(Interface *));
+    set_conn_var(CONN_VAR_INGRESS_INTF, id(ingress_intf));
     return ingress_intf;
 }
 
 Candidates *Model::get_candidates() const {
-    Candidates *candidates;
-    memcpy(&candidates, state->conn_state[state->conn].candidates,
-           sizeof(Candidates *));
-    return candidates;
+    return storage.object<Candidates>(conn_var(CONN_VAR_CANDIDATES));
 }
 
 Candidates *Model::set_candidates(Candidates &&candidates) const {
-    Candidates *new_candidates = new Candidates(std::move(candidates));
-    new_candidates = storage.store_candidates(new_candidates);
-    memcpy(state->conn_state[state->conn].candidates, &new_candidates,
-           sizeof(Candidates *));
+    Candidates *new_candidates =
+        storage.store_candidates(std::move(candidates));
+    set_conn_var(CONN_VAR_CANDIDATES, storage.id(new_candidates));
     return new_candidates;
 }
 
 Candidates *Model::reset_candidates() const {
-    memset(state->conn_state[state->conn].candidates, 0, sizeof(Candidates *));
+    set_conn_var(CONN_VAR_CANDIDATES, 0);
     return nullptr;
 }
 
 InjectionResults *Model::get_injection_results() const {
-    InjectionResults *results;
-    memcpy(&results, state->conn_state[state->conn].inj_results,
-           sizeof(InjectionResults *));
-    return results;
+    return storage.object<InjectionResults>(conn_var(CONN_VAR_INJ_RESULTS));
 }
 
 InjectionResults *
 Model::set_injection_results(InjectionResults &&results) const {
-    InjectionResults *new_results = new InjectionResults(std::move(results));
-    new_results = storage.store_injection_results(new_results);
-    memcpy(state->conn_state[state->conn].inj_results, &new_results,
-           sizeof(InjectionResults *));
+    InjectionResults *new_results =
+        storage.store_injection_results(std::move(results));
+    set_conn_var(CONN_VAR_INJ_RESULTS, storage.id(new_results));
     return new_results;
 }
 
+// The results must have been stored (e.g., cached injection results)
 InjectionResults *
 Model::set_injection_results(InjectionResults *results) const {
-    results = storage.store_injection_results(results);
-    memcpy(state->conn_state[state->conn].inj_results, &results,
-           sizeof(InjectionResults *));
+    set_conn_var(CONN_VAR_INJ_RESULTS, storage.id(results));
     return results;
 }
 
 InjectionResults *Model::reset_injection_results() const {
-    memset(state->conn_state[state->conn].inj_results, 0,
-           sizeof(InjectionResults *));
+    set_conn_var(CONN_VAR_INJ_RESULTS, 0);
     return nullptr;
 }
 
 FIB *Model::get_fib() const {
-    FIB *fib;
-    memcpy(&fib, state->conn_state[state->conn].fib, sizeof(FIB *));
-    return fib;
+    return storage.object<FIB>(conn_var(CONN_VAR_FIB));
+}
+
+FIB *Model::get_fib_for_conn(int conn) const {
+    return storage.object<FIB>(conn_var(conn, CONN_VAR_FIB));
 }
 
 FIB *Model::set_fib(FIB &&fib) const {
-    FIB *new_fib = new FIB(std::move(fib));
-    new_fib = storage.store_fib(new_fib);
-    memcpy(state->conn_state[state->conn].fib, &new_fib, sizeof(FIB *));
+    FIB *new_fib = storage.store_fib(std::move(fib));
+    set_conn_var(CONN_VAR_FIB, storage.id(new_fib));
     return new_fib;
 }
 
+// The FIB must have been stored (e.g., precomputed FIBs)
+FIB *Model::set_fib(FIB *fib) const {
+    set_conn_var(CONN_VAR_FIB, storage.id(fib));
+    return fib;
+}
+
 void Model::update_fib() const {
-    FIB fib;
     EqClass *ec = model.get_dst_ip_ec();
+
+    // use the precomputed data plane if available
+    FIB *precomputed =
+        FIBMgr::get().get_fib(ec, model.get_openflow_update_state());
+    if (precomputed) {
+        model.set_fib(precomputed);
+        return;
+    }
+
+    FIB fib;
     IPv4Address addr = ec->representative_addr();
 
-    // collect IP next hops from routing tables
-    for (const auto &[_, node] : this->network->nodes()) {
+    // collect IP next hops from routing tables, in the order of the indices
+    for (Node *node : this->network->nodes_by_idx()) {
         fib.set_ipnhs(node, node->get_ipnhs(addr));
     }
 
@@ -324,130 +380,118 @@ void Model::update_fib() const {
 }
 
 Choices *Model::get_path_choices() const {
-    Choices *path_choices;
-    memcpy(&path_choices, state->conn_state[state->conn].path_choices,
-           sizeof(Choices *));
-    return path_choices;
+    return storage.object<Choices>(conn_var(CONN_VAR_PATH_CHOICES));
 }
 
 Choices *Model::set_path_choices(Choices &&path_choices) const {
-    Choices *new_path_choices = new Choices(std::move(path_choices));
-    new_path_choices = storage.store_choices(new_path_choices);
-    memcpy(state->conn_state[state->conn].path_choices, &new_path_choices,
-           sizeof(Choices *));
+    Choices *new_path_choices = storage.store_choices(std::move(path_choices));
+    set_conn_var(CONN_VAR_PATH_CHOICES, storage.id(new_path_choices));
     return new_path_choices;
 }
 
 VisitedHops *Model::get_visited_hops() const {
-    VisitedHops *hops;
-    memcpy(&hops, state->conn_state[state->conn].visited_hops,
-           sizeof(VisitedHops *));
-    return hops;
+    return storage.object<VisitedHops>(conn_var(CONN_VAR_VISITED_HOPS));
 }
 
 VisitedHops *Model::set_visited_hops(VisitedHops &&hops) const {
-    VisitedHops *new_hops = new VisitedHops(std::move(hops));
-    new_hops = storage.store_visited_hops(new_hops);
-    memcpy(state->conn_state[state->conn].visited_hops, &new_hops,
-           sizeof(VisitedHops *));
+    VisitedHops *new_hops = storage.store_visited_hops(std::move(hops));
+    set_conn_var(CONN_VAR_VISITED_HOPS, storage.id(new_hops));
     return new_hops;
 }
 
 int Model::get_process_id() const {
-    return state->process_id;
+    return var(VAR_PROCESS_ID);
 }
 
 int Model::set_process_id(int process_id) const {
-    return state->process_id = process_id;
+    set_var(VAR_PROCESS_ID, process_id);
+    return process_id;
 }
 
 int Model::get_choice() const {
-    return state->choice;
+    return var(VAR_CHOICE);
 }
 
 int Model::set_choice(int choice) const {
-    return state->choice = choice;
+    set_var(VAR_CHOICE, choice);
+    return choice;
 }
 
 int Model::get_choice_count() const {
-    return state->choice_count;
+    return var(VAR_CHOICE_COUNT);
 }
 
 int Model::set_choice_count(int choice_count) const {
-    return state->choice_count = choice_count;
+    set_var(VAR_CHOICE_COUNT, choice_count);
+    return choice_count;
 }
 
 int Model::get_conn() const {
-    return state->conn;
+    return var(VAR_CONN);
 }
 
 int Model::set_conn(int conn) const {
-    return state->conn = conn;
+    set_var(VAR_CONN, conn);
+    return conn;
 }
 
 int Model::get_num_conns() const {
-    return state->num_conns;
+    return var(VAR_NUM_CONNS);
 }
 
 int Model::set_num_conns(int num_conns) const {
-    return state->num_conns = num_conns;
+    set_var(VAR_NUM_CONNS, num_conns);
+    return num_conns;
 }
 
 PacketHistory *Model::get_pkt_hist() const {
-    PacketHistory *pkt_hist;
-    memcpy(&pkt_hist, state->pkt_hist, sizeof(PacketHistory *));
-    return pkt_hist;
+    return storage.object<PacketHistory>(var(VAR_PKT_HIST));
 }
 
 PacketHistory *Model::set_pkt_hist(PacketHistory &&pkt_hist) const {
-    PacketHistory *new_pkt_hist = new PacketHistory(std::move(pkt_hist));
-    new_pkt_hist = storage.store_pkt_hist(new_pkt_hist);
-    memcpy(state->pkt_hist, &new_pkt_hist, sizeof(PacketHistory *));
+    PacketHistory *new_pkt_hist = storage.store_pkt_hist(std::move(pkt_hist));
+    set_var(VAR_PKT_HIST, storage.id(new_pkt_hist));
     return new_pkt_hist;
 }
 
 OpenflowUpdateState *Model::get_openflow_update_state() const {
-    OpenflowUpdateState *update_state;
-    memcpy(&update_state, state->openflow_update_state,
-           sizeof(OpenflowUpdateState *));
-    return update_state;
+    return storage.object<OpenflowUpdateState>(
+        var(VAR_OPENFLOW_UPDATE_STATE));
 }
 
 OpenflowUpdateState *
 Model::set_openflow_update_state(OpenflowUpdateState &&update_state) const {
     OpenflowUpdateState *new_state =
-        new OpenflowUpdateState(std::move(update_state));
-    new_state = storage.store_of_update_state(new_state);
-    memcpy(state->openflow_update_state, &new_state,
-           sizeof(OpenflowUpdateState *));
+        storage.store_of_update_state(std::move(update_state));
+    set_var(VAR_OPENFLOW_UPDATE_STATE, storage.id(new_state));
     return new_state;
 }
 
 bool Model::get_violated() const {
-    return state->violated;
+    return var(VAR_VIOLATED);
 }
 
 bool Model::set_violated(bool violated) const {
-    return (state->violated = violated);
+    set_var(VAR_VIOLATED, violated);
+    return violated;
 }
 
 int Model::get_correlated_inv_idx() const {
-    return state->correlated_inv_idx;
+    return var(VAR_CORRELATED_INV_IDX);
 }
 
 int Model::set_correlated_inv_idx(int idx) const {
-    return state->correlated_inv_idx = idx;
+    set_var(VAR_CORRELATED_INV_IDX, idx);
+    return idx;
 }
 
 ReachCounts *Model::get_reach_counts() const {
-    ReachCounts *reach_counts;
-    memcpy(&reach_counts, state->reach_counts, sizeof(ReachCounts *));
-    return reach_counts;
+    return storage.object<ReachCounts>(var(VAR_REACH_COUNTS));
 }
 
 ReachCounts *Model::set_reach_counts(ReachCounts &&reach_counts) const {
-    ReachCounts *new_reach_counts = new ReachCounts(std::move(reach_counts));
-    new_reach_counts = storage.store_reach_counts(new_reach_counts);
-    memcpy(state->reach_counts, &new_reach_counts, sizeof(ReachCounts *));
+    ReachCounts *new_reach_counts =
+        storage.store_reach_counts(std::move(reach_counts));
+    set_var(VAR_REACH_COUNTS, storage.id(new_reach_counts));
     return new_reach_counts;
 }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <tuple>
+
+#include "lib/idmap.hpp"
+#include "model-variant.h"
 
 class Candidates;
 class Choices;
@@ -16,7 +20,6 @@ class PacketHistory;
 class Payload;
 class ReachCounts;
 class VisitedHops;
-struct State;
 
 class Model {
 private:
@@ -24,13 +27,38 @@ private:
     // to safely assume that the pointer to that variable remains the same
     // through out the entire execution of the spin program.
     State *state;
+    const model_variant *variant; // static model or one loaded by ModelMgr
     Network *network;
     OpenflowProcess *openflow;
 
+    // Dense IDs of the static objects referred to by the state vector. The
+    // interned objects are assigned IDs by UniqueStorage.
+    mutable std::
+        tuple<IDMap<EqClass>, IDMap<Payload>, IDMap<Node>, IDMap<Interface>>
+            ids;
+
+    template <class T>
+    uint32_t id(T *obj) const {
+        return std::get<IDMap<T>>(ids).id(obj);
+    }
+    template <class T>
+    T *object(uint32_t id) const {
+        return std::get<IDMap<T>>(ids).object(id);
+    }
+
+    uint32_t conn_var(int conn, model_conn_var) const;
+    uint32_t conn_var(model_conn_var) const; // of the current connection
+    void set_conn_var(model_conn_var, uint32_t) const;
+    uint32_t var(model_var) const;
+    void set_var(model_var, uint32_t) const;
+
     Model();
     friend class API;
+    friend class Explorer;
     friend class Plankton;
     void set_state(State *);
+    void bind_state(State *);
+    void set_variant(const model_variant *);
     void init(Network *, OpenflowProcess *);
     void reset();
 
@@ -40,6 +68,8 @@ public:
     Model &operator=(const Model &) = delete;
 
     static Model &get();
+    const model_variant *get_variant() const { return variant; }
+    int get_max_conns() const;
 
     /**
      * per-connection state variables
@@ -56,6 +86,7 @@ public:
     uint16_t get_proto_state_for_conn(int) const;
     uint16_t set_proto_state(int) const;
     uint32_t get_src_ip() const;
+    uint32_t get_src_ip_for_conn(int) const;
     uint32_t set_src_ip(uint32_t) const;
     EqClass *get_dst_ip_ec() const;
     EqClass *set_dst_ip_ec(EqClass *) const;
@@ -80,6 +111,7 @@ public:
     int get_fwd_mode_for_conn(int) const;
     int set_fwd_mode(int) const;
     Node *get_pkt_location() const;
+    Node *get_pkt_location_for_conn(int) const;
     Node *set_pkt_location(Node *) const;
     Interface *get_ingress_intf() const;
     Interface *set_ingress_intf(Interface *) const;
@@ -92,7 +124,9 @@ public:
     InjectionResults *reset_injection_results() const;
     // per-flow data plane state
     FIB *get_fib() const;
+    FIB *get_fib_for_conn(int) const;
     FIB *set_fib(FIB &&) const;
+    FIB *set_fib(FIB *) const;
     void update_fib() const; // update FIB according to the current EC
     Choices *get_path_choices() const;
     Choices *set_path_choices(Choices &&) const;
@@ -0,0 +1,172 @@
+/**
+ * Accessors of the state variables of a model variant. This file is compiled
+ * along with the Spin-generated verifier, either into the default static model
+ * or into a model variant generated at run time (see ModelMgr), and it is the
+ * only place other than network.pml that knows the state vector layout.
+ */
+
+#include "model-variant.h"
+
+#include <string.h>
+
+#include "pan.h"
+
+int spin_main(int argc, const char *argv[]);
+extern double nstates, hcmp; // states stored and hash conflicts
+
+#define CONN_VAR(var)                                                          \
+    static uint32_t get_conn_##var(const State *s, int conn) {                 \
+        return s->conn_state[conn].var;                                        \
+    }                                                                          \
+    static void set_conn_##var(State *s, int conn, uint32_t value) {           \
+        s->conn_state[conn].var = value;                                       \
+    }
+
+// 32-bit values stored as int[4 / SIZEOF_INT]
+#define CONN_VAR_U32(var)                                                      \
+    static uint32_t get_conn_##var(const State *s, int conn) {                 \
+        uint32_t value;                                                        \
+        memcpy(&value, s->conn_state[conn].var, sizeof(value));                \
+        return value;                                                          \
+    }                                                                          \
+    static void set_conn_##var(State *s, int conn, uint32_t value) {           \
+        memcpy(s->conn_state[conn].var, &value, sizeof(value));                \
+    }
+
+#define VAR(var)                                                               \
+    static uint32_t get_##var(const State *s) {                                \
+        return s->var;                                                         \
+    }                                                                          \
+    static void set_##var(State *s, uint32_t value) {                          \
+        s->var = value;                                                        \
+    }
+
+#define CONN_ACCESSORS(id, var)                                                \
+    .get_conn_var[id] = get_conn_##var, .set_conn_var[id] = set_conn_##var
+#define ACCESSORS(id, var) .get_var[id] = get_##var, .set_var[id] = set_##var
+
+CONN_VAR(executable)
+CONN_VAR(proto_state)
+CONN_VAR_U32(src_ip)
+CONN_VAR(dst_ip_ec)
+CONN_VAR(src_port)
+CONN_VAR(dst_port)
+CONN_VAR_U32(seq)
+CONN_VAR_U32(ack)
+CONN_VAR(payload)
+CONN_VAR(src_node)
+CONN_VAR(tx_node)
+CONN_VAR(rx_node)
+CONN_VAR(fwd_mode)
+CONN_VAR(pkt_location)
+CONN_VAR(ingress_intf)
+CONN_VAR(candidates)
+CONN_VAR(inj_results)
+CONN_VAR(fib)
+CONN_VAR(path_choices)
+#ifdef HAS_VISITED_HOPS
+CONN_VAR(visited_hops)
+#endif
+
+VAR(process_id)
+VAR(choice)
+VAR(choice_count)
+VAR(conn)
+VAR(num_conns)
+VAR(pkt_hist)
+#ifdef HAS_OPENFLOW_UPDATE_STATE
+VAR(openflow_update_state)
+#endif
+VAR(violated)
+#ifdef HAS_CORRELATED_INV_IDX
+VAR(correlated_inv_idx)
+#endif
+#ifdef HAS_REACH_COUNTS
+VAR(reach_counts)
+#endif
+
+#ifdef HAS_OPENFLOW_UPDATE_STATE
+#define F_OPENFLOW_UPDATE_STATE MODEL_OPENFLOW_UPDATE_STATE
+#else
+#define F_OPENFLOW_UPDATE_STATE 0
+#endif
+#ifdef HAS_CORRELATED_INV_IDX
+#define F_CORRELATED_INV_IDX MODEL_CORRELATED_INV_IDX
+#else
+#define F_CORRELATED_INV_IDX 0
+#endif
+#ifdef HAS_REACH_COUNTS
+#define F_REACH_COUNTS MODEL_REACH_COUNTS
+#else
+#define F_REACH_COUNTS 0
+#endif
+#ifdef HAS_VISITED_HOPS
+#define F_VISITED_HOPS MODEL_VISITED_HOPS
+#else
+#define F_VISITED_HOPS 0
+#endif
+
+#if defined(BITSTATE)
+#define F_SEARCH_MODE SEARCH_BITSTATE
+#elif defined(HC4)
+#define F_SEARCH_MODE SEARCH_HASHCOMPACT
+#elif defined(COLLAPSE)
+#define F_SEARCH_MODE SEARCH_COLLAPSE
+#else
+#define F_SEARCH_MODE SEARCH_EXHAUSTIVE
+#endif
+
+static const struct model_variant variant = {
+    .max_conns = MAX_CONNS,
+    .features = F_OPENFLOW_UPDATE_STATE | F_CORRELATED_INV_IDX |
+                F_REACH_COUNTS | F_VISITED_HOPS,
+    .state_size = sizeof(State),
+    .search_mode = F_SEARCH_MODE,
+    .spin_main = spin_main,
+    .states_stored = &nstates,
+    .hash_conflicts = &hcmp,
+
+    CONN_ACCESSORS(CONN_VAR_EXECUTABLE, executable),
+    CONN_ACCESSORS(CONN_VAR_PROTO_STATE, proto_state),
+    CONN_ACCESSORS(CONN_VAR_SRC_IP, src_ip),
+    CONN_ACCESSORS(CONN_VAR_DST_IP_EC, dst_ip_ec),
+    CONN_ACCESSORS(CONN_VAR_SRC_PORT, src_port),
+    CONN_ACCESSORS(CONN_VAR_DST_PORT, dst_port),
+    CONN_ACCESSORS(CONN_VAR_SEQ, seq),
+    CONN_ACCESSORS(CONN_VAR_ACK, ack),
+    CONN_ACCESSORS(CONN_VAR_PAYLOAD, payload),
+    CONN_ACCESSORS(CONN_VAR_SRC_NODE, src_node),
+    CONN_ACCESSORS(CONN_VAR_TX_NODE, tx_node),
+    CONN_ACCESSORS(CONN_VAR_RX_NODE, rx_node),
+    CONN_ACCESSORS(CONN_VAR_FWD_MODE, fwd_mode),
+    CONN_ACCESSORS(CONN_VAR_PKT_LOCATION, pkt_location),
+    CONN_ACCESSORS(CONN_VAR_INGRESS_INTF, ingress_intf),
+    CONN_ACCESSORS(CONN_VAR_CANDIDATES, candidates),
+    CONN_ACCESSORS(CONN_VAR_INJ_RESULTS, inj_results),
+    CONN_ACCESSORS(CONN_VAR_FIB, fib),
+    CONN_ACCESSORS(CONN_VAR_PATH_CHOICES, path_choices),
+#ifdef HAS_VISITED_HOPS
+    CONN_ACCESSORS(CONN_VAR_VISITED_HOPS, visited_hops),
+#endif
+
+    ACCESSORS(VAR_PROCESS_ID, process_id),
+    ACCESSORS(VAR_CHOICE, choice),
+    ACCESSORS(VAR_CHOICE_COUNT, choice_count),
+    ACCESSORS(VAR_CONN, conn),
+    ACCESSORS(VAR_NUM_CONNS, num_conns),
+    ACCESSORS(VAR_PKT_HIST, pkt_hist),
+#ifdef HAS_OPENFLOW_UPDATE_STATE
+    ACCESSORS(VAR_OPENFLOW_UPDATE_STATE, openflow_update_state),
+#endif
+    ACCESSORS(VAR_VIOLATED, violated),
+#ifdef HAS_CORRELATED_INV_IDX
+    ACCESSORS(VAR_CORRELATED_INV_IDX, correlated_inv_idx),
+#endif
+#ifdef HAS_REACH_COUNTS
+    ACCESSORS(VAR_REACH_COUNTS, reach_counts),
+#endif
+};
+
+const struct model_variant *neo_model_variant(void) {
+    return &variant;
+}
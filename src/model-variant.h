@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Optional state variables of the Promela network model (network.pml). Each
+ * model variant is compiled with only the state variables needed by the
+ * verified invariant, so that the state vector is kept as small as possible.
+ * Each of them is enabled by defining the `HAS_*` macro noted below when
+ * generating and compiling the model.
+ */
+#define MODEL_OPENFLOW_UPDATE_STATE 0x1 // HAS_OPENFLOW_UPDATE_STATE
+#define MODEL_CORRELATED_INV_IDX    0x2 // HAS_CORRELATED_INV_IDX
+#define MODEL_REACH_COUNTS          0x4 // HAS_REACH_COUNTS
+#define MODEL_VISITED_HOPS          0x8 // HAS_VISITED_HOPS
+#define MODEL_ALL_FEATURES          0xf
+
+// Spin state storage modes (https://spinroot.com/spin/Man/Pan.html#B)
+#define SEARCH_EXHAUSTIVE  0 // NOCOMP, full state vectors
+#define SEARCH_COLLAPSE    1 // COLLAPSE, compressed state vectors
+#define SEARCH_HASHCOMPACT 2 // HC4, 64-bit state hashes
+#define SEARCH_BITSTATE    3 // BITSTATE, supertrace
+
+// per-connection state variables
+enum model_conn_var {
+    CONN_VAR_EXECUTABLE,
+    CONN_VAR_PROTO_STATE,
+    CONN_VAR_SRC_IP,
+    CONN_VAR_DST_IP_EC,
+    CONN_VAR_SRC_PORT,
+    CONN_VAR_DST_PORT,
+    CONN_VAR_SEQ,
+    CONN_VAR_ACK,
+    CONN_VAR_PAYLOAD,
+    CONN_VAR_SRC_NODE,
+    CONN_VAR_TX_NODE,
+    CONN_VAR_RX_NODE,
+    CONN_VAR_FWD_MODE,
+    CONN_VAR_PKT_LOCATION,
+    CONN_VAR_INGRESS_INTF,
+    CONN_VAR_CANDIDATES,
+    CONN_VAR_INJ_RESULTS,
+    CONN_VAR_FIB,
+    CONN_VAR_PATH_CHOICES,
+    CONN_VAR_VISITED_HOPS,
+    NUM_CONN_VARS,
+};
+
+// non-connection specific, system-wide state variables
+enum model_var {
+    VAR_PROCESS_ID,
+    VAR_CHOICE,
+    VAR_CHOICE_COUNT,
+    VAR_CONN,
+    VAR_NUM_CONNS,
+    VAR_PKT_HIST,
+    VAR_OPENFLOW_UPDATE_STATE,
+    VAR_VIOLATED,
+    VAR_CORRELATED_INV_IDX,
+    VAR_REACH_COUNTS,
+    NUM_VARS,
+};
+
+struct State;
+
+/**
+ * Entry points of a compiled model variant. The accessors of the state
+ * variables that are not in the variant are NULL.
+ */
+struct model_variant {
+    uint32_t max_conns;   // MAX_CONNS of the variant
+    uint32_t features;    // MODEL_* optional state variables
+    uint32_t state_size;  // sizeof(State)
+    uint32_t search_mode; // SEARCH_*
+    int (*spin_main)(int argc, const char *argv[]);
+    // Spin counters of the run (one per EC process)
+    const double *states_stored;
+    const double *hash_conflicts;
+    uint32_t (*get_conn_var[NUM_CONN_VARS])(const struct State *, int);
+    void (*set_conn_var[NUM_CONN_VARS])(struct State *, int, uint32_t);
+    uint32_t (*get_var[NUM_VARS])(const struct State *);
+    void (*set_var[NUM_VARS])(struct State *, uint32_t);
+};
+
+const struct model_variant *neo_model_variant(void);
+
+#ifdef __cplusplus
+}
+#endif
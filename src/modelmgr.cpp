@@ -0,0 +1,277 @@
+#include "modelmgr.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "lib/hash.hpp"
+#include "logger.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+#ifndef MODEL_SRC_DIR
+#define MODEL_SRC_DIR ""
+#endif
+#ifndef MODEL_CFLAGS
+#define MODEL_CFLAGS ""
+#endif
+#ifndef MODEL_CC
+#define MODEL_CC "cc"
+#endif
+#ifndef SPIN_EXECUTABLE
+#define SPIN_EXECUTABLE "spin"
+#endif
+#ifndef SIZEOF_INT
+#define SIZEOF_INT 4
+#endif
+
+static const char *model_sources[] = {"network.pml", "model-variant.c",
+                                      "model-variant.h", "api.hpp"};
+
+// Compile flags of the storage modes, indexed by SEARCH_*
+static const char *search_mode_macros[] = {"NOCOMP", "COLLAPSE", "HC4",
+                                           "BITSTATE"};
+
+static const pair<uint32_t, const char *> feature_macros[] = {
+    {MODEL_OPENFLOW_UPDATE_STATE, "HAS_OPENFLOW_UPDATE_STATE"},
+    {MODEL_CORRELATED_INV_IDX,    "HAS_CORRELATED_INV_IDX"   },
+    {MODEL_REACH_COUNTS,          "HAS_REACH_COUNTS"         },
+    {MODEL_VISITED_HOPS,          "HAS_VISITED_HOPS"         },
+};
+
+/**
+ * Runs the command in `dir` with stdout/stderr appended to `log`, and returns
+ * the exit status (-1 if it didn't exit normally).
+ */
+static int run_command(const vector<string> &args,
+                       const fs::path &dir,
+                       const fs::path &log) {
+    vector<char *> argv;
+    for (const string &arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    // Block SIGCHLD so that the child isn't reaped by the signal handlers of
+    // Plankton before we get its exit status.
+    sigset_t mask, orig_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &orig_mask);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        sigprocmask(SIG_SETMASK, &orig_mask, nullptr);
+        logger.error("fork()", errno);
+    } else if (pid == 0) {
+        sigprocmask(SIG_SETMASK, &orig_mask, nullptr);
+        int fd = open(log.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0 || chdir(dir.c_str()) < 0) {
+            _exit(127);
+        }
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    sigprocmask(SIG_SETMASK, &orig_mask, nullptr);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+ModelMgr::ModelMgr() : _digest(0) {}
+
+ModelMgr &ModelMgr::get() {
+    static ModelMgr instance;
+    return instance;
+}
+
+void ModelMgr::init(const string &cache_dir) {
+    reset();
+
+    // The digest covers everything that affects the compiled variants
+    string content = string(SPIN_EXECUTABLE) + '\0' + MODEL_CC + '\0' +
+                     MODEL_CFLAGS + '\0';
+    for (const char *src : model_sources) {
+        ifstream ifs(fs::path(MODEL_SRC_DIR) / src);
+        if (!ifs) {
+            logger.info("Model sources not found, using the static model");
+            return;
+        }
+        content.append(istreambuf_iterator<char>(ifs),
+                       istreambuf_iterator<char>());
+    }
+
+    _digest = ::hash::hash(content.data(), content.size());
+    fs::create_directories(cache_dir);
+    _cache_dir = fs::canonical(cache_dir);
+}
+
+void ModelMgr::reset() {
+    for (auto &[_, handle] : _handles) {
+        dlclose(handle);
+    }
+    _handles.clear();
+    _cache_dir.clear();
+    _digest = 0;
+}
+
+string ModelMgr::variant_name(uint32_t max_conns,
+                              uint32_t features,
+                              uint32_t search_mode) const {
+    stringstream ss;
+    ss << "model-c" << max_conns << "-f" << hex << features << "-s"
+       << search_mode << "-" << _digest;
+    return ss.str();
+}
+
+/**
+ * The variant library is built in a private directory and then moved into the
+ * cache directory, as concurrent invariant processes (or other runs sharing
+ * the cache) may be generating the same variant at the same time.
+ */
+bool ModelMgr::generate(uint32_t max_conns,
+                        uint32_t features,
+                        uint32_t search_mode,
+                        const string &lib_path) const {
+    string build_dir = (fs::path(_cache_dir) / ".build-XXXXXX").string();
+    if (!mkdtemp(build_dir.data())) {
+        logger.warn("mkdtemp(): " + string(strerror(errno)));
+        return false;
+    }
+
+    const fs::path log = fs::path(build_dir) / "build.log";
+    const string src_dir = MODEL_SRC_DIR;
+    vector<string> defs = {"-DMAX_CONNS=" + to_string(max_conns),
+                           "-DSIZEOF_INT=" + to_string(SIZEOF_INT)};
+    for (const auto &[feature, macro] : feature_macros) {
+        if (features & feature) {
+            defs.push_back(string("-D") + macro);
+        }
+    }
+
+    // Generate pan.c and pan.h from the Promela model
+    vector<string> spin_cmd = {SPIN_EXECUTABLE, "-a"};
+    spin_cmd.insert(spin_cmd.end(), defs.begin(), defs.end());
+    spin_cmd.push_back(src_dir + "/network.pml");
+    if (run_command(spin_cmd, build_dir, log) != 0) {
+        logger.warn("Failed to generate the model, see " + log.string());
+        return false;
+    }
+
+    // Same as the `model.c` of the static model (see CMakeLists.txt)
+    {
+        ifstream pan_c(fs::path(build_dir) / "pan.c");
+        ofstream model_c(fs::path(build_dir) / "model.c");
+        model_c << "#define exit(...) verify_exit(__VA_ARGS__)\n"
+                << "#define main(...) spin_main(__VA_ARGS__)\n"
+                << pan_c.rdbuf();
+    }
+
+    // Compile the variant into a shared library. The verifier symbols are bound
+    // within the library (-Bsymbolic), so that they aren't resolved to the ones
+    // of the static model in the executable.
+    vector<string> cc_cmd = {MODEL_CC,         "-O2",           "-fPIC",
+                             "-shared",        "-w",            "-Wl,-Bsymbolic",
+                             "-I" + build_dir, "-I" + src_dir};
+    istringstream cflags(MODEL_CFLAGS);
+    copy(istream_iterator<string>(cflags), istream_iterator<string>(),
+         back_inserter(cc_cmd));
+    cc_cmd.insert(cc_cmd.end(), defs.begin(), defs.end());
+    cc_cmd.push_back(string("-D") + search_mode_macros[search_mode]);
+    cc_cmd.push_back("-DVECTORSZ=" + to_string(MODEL_VECTORSZ(max_conns)));
+    cc_cmd.insert(cc_cmd.end(), {"-o", "model.so", "model.c",
+                                 src_dir + "/model-variant.c"});
+    if (run_command(cc_cmd, build_dir, log) != 0) {
+        logger.warn("Failed to compile the model, see " + log.string());
+        return false;
+    }
+
+    fs::rename(fs::path(build_dir) / "model.so", lib_path);
+    fs::remove_all(build_dir);
+    return true;
+}
+
+/**
+ * Loads the model variant with the given optional state variables (MODEL_*),
+ * storage mode (SEARCH_*), and at least `max_conns` connections. The number of
+ * connections is rounded up to a power of 2 to share variants among similar
+ * invariants.
+ */
+const model_variant *
+ModelMgr::load(size_t max_conns, uint32_t features, uint32_t search_mode) {
+    const model_variant *static_model = neo_model_variant();
+    uint32_t conns = 1;
+    while (conns < max_conns && conns < static_model->max_conns) {
+        conns <<= 1;
+    }
+    conns = min(conns, static_model->max_conns);
+    features &= MODEL_ALL_FEATURES;
+
+    if (conns == static_model->max_conns &&
+        features == static_model->features &&
+        search_mode == static_model->search_mode) {
+        return static_model;
+    }
+
+    if (_cache_dir.empty()) {
+        if (search_mode != static_model->search_mode) {
+            logger.warn("Model variants unavailable, using exhaustive search");
+        }
+        return static_model;
+    }
+
+    const string name = variant_name(conns, features, search_mode);
+    void *handle = nullptr;
+    auto it = _handles.find({conns, features, search_mode});
+
+    if (it != _handles.end()) {
+        handle = it->second;
+    } else {
+        const string lib_path = (fs::path(_cache_dir) / (name + ".so")).string();
+
+        if (!fs::exists(lib_path)) {
+            logger.info("Generating model variant " + name);
+            if (!generate(conns, features, search_mode, lib_path)) {
+                logger.warn("Using the static model");
+                return static_model;
+            }
+        }
+
+        handle = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            logger.warn(string("dlopen(): ") + dlerror());
+            logger.warn("Using the static model");
+            return static_model;
+        }
+        _handles.emplace(make_tuple(conns, features, search_mode), handle);
+    }
+
+    auto entry = reinterpret_cast<const model_variant *(*)()>(
+        dlsym(handle, "neo_model_variant"));
+    if (!entry) {
+        logger.error(string("dlsym(): ") + dlerror());
+    }
+
+    const model_variant *variant = entry();
+    logger.info("Model variant " + name + ": state vector " +
+                to_string(variant->state_size) + " bytes (static model: " +
+                to_string(static_model->state_size) + " bytes)");
+    return variant;
+}
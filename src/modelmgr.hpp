@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "model-variant.h"
+
+// State vector size for the given number of connections (see network.pml)
+#define MODEL_VECTORSZ(conns) (128 + 72 * (conns))
+
+/**
+ * ModelMgr generates, caches, and loads the Promela model variants specialized
+ * to the number of concurrent connections and the optional state variables
+ * used by each invariant, with the Spin storage mode of `--search-mode`.
+ *
+ * A variant is generated from network.pml with Spin and compiled into a shared
+ * library, which is kept in the cache directory to be reused by the other
+ * invariants and the later runs. The library name includes a digest of the
+ * model sources and the compile flags, so stale variants are never loaded. If a
+ * variant cannot be generated or loaded, the default static model (compiled
+ * with MAX_CONNS and all the state variables) is used instead.
+ */
+class ModelMgr {
+private:
+    std::string _cache_dir; // empty if variants are disabled
+    size_t _digest;         // digest of the model sources and flags
+    // Loaded libraries by (max_conns, features, search_mode). They are only
+    // closed by reset() but not at exit, since an EC process exits from within
+    // Spin.
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t>, void *> _handles;
+
+    ModelMgr();
+    std::string variant_name(uint32_t max_conns,
+                             uint32_t features,
+                             uint32_t search_mode) const;
+    bool generate(uint32_t max_conns,
+                  uint32_t features,
+                  uint32_t search_mode,
+                  const std::string &lib_path) const;
+
+public:
+    // Disable the copy/move constructors and the assignment operators
+    ModelMgr(const ModelMgr &) = delete;
+    ModelMgr(ModelMgr &&) = delete;
+    ModelMgr &operator=(const ModelMgr &) = delete;
+    ModelMgr &operator=(ModelMgr &&) = delete;
+
+    static ModelMgr &get();
+
+    void init(const std::string &cache_dir);
+    void reset();
+
+    // Returns the smallest variant that fits, or the static model
+    const model_variant *
+    load(size_t max_conns, uint32_t features, uint32_t search_mode);
+};
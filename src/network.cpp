@@ -9,6 +9,8 @@ void Network::add_node(Node *node) {
     if (res.second == false) {
         logger.error("Duplicate node: " + res.first->first);
     }
+    node->idx = _nodes_by_idx.size();
+    _nodes_by_idx.push_back(node);
 }
 
 void Network::add_link(Link *link) {
@@ -63,6 +65,7 @@ void Network::reset() {
     }
 
     this->_nodes.clear();
+    this->_nodes_by_idx.clear();
     this->_mbs.clear();
 
     for (const auto &link : this->_links) {
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "l2-lan.hpp"
 #include "link.hpp"
@@ -24,6 +25,7 @@ class Network {
 private:
     Plankton *_plankton;
     std::unordered_map<std::string, Node *> _nodes;
+    std::vector<Node *> _nodes_by_idx; // indexed by Node::get_idx()
     std::set<Link *, LinkCompare> _links;
     std::unordered_set<Middlebox *> _mbs;
 
@@ -47,6 +49,9 @@ public:
 
     void reset();
     const decltype(_nodes) &nodes() const { return _nodes; }
+    const decltype(_nodes_by_idx) &nodes_by_idx() const {
+        return _nodes_by_idx;
+    }
     const decltype(_links) &links() const { return _links; }
     const decltype(_mbs) &middleboxes() const { return _mbs; }
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
@@ -8,12 +9,14 @@
 #include "fib.hpp"
 #include "interface.hpp"
 #include "l2-lan.hpp"
+#include "lib/idmap.hpp"
 #include "lib/ip.hpp"
 #include "routingtable.hpp"
 
-class Node {
+class Node : public DenseID {
 protected:
     std::string name;
+    size_t idx = SIZE_MAX; // dense index in the network (see FIB)
 
     // interfaces indexed by name and ip address
     std::map<std::string, Interface *> intfs;    // all interfaces
@@ -30,6 +33,7 @@ protected:
 
 protected:
     friend class ConfigParser;
+    friend class Network;
     Node() = default;
     void add_interface(Interface *interface);
 
@@ -43,6 +47,7 @@ public:
 
     virtual std::string to_string() const;
     virtual std::string get_name() const;
+    size_t get_idx() const { return idx; }
     virtual bool has_ip(const IPv4Address &addr) const;
     virtual bool is_l3_only() const;
     virtual bool is_emulated() const;
@@ -3,7 +3,9 @@
 #include <cstdint>
 #include <string>
 
-class Payload {
+#include "lib/idmap.hpp"
+
+class Payload : public DenseID {
 private:
     uint8_t *buffer;
     uint32_t size;
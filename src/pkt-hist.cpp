@@ -1,10 +1,45 @@
 #include "pkt-hist.hpp"
 
+#include <algorithm>
+
+#include "lib/hash.hpp"
+#include "logger.hpp"
 #include "middlebox.hpp"
 
 NodePacketHistory::NodePacketHistory(Packet *p, NodePacketHistory *h) :
     last_pkt(p),
-    past_hist(h) {}
+    past_hist(h),
+    skip(h),
+    depth(depth_of(h) + 1) {
+    // Skip over two equal-length skips at once, so that the skip lengths along
+    // any path form a skew-binary decomposition of the depth.
+    NodePacketHistory *h_skip = h ? h->skip : nullptr;
+    NodePacketHistory *h_skip_skip = h_skip ? h_skip->skip : nullptr;
+    if (h && depth_of(h) - depth_of(h_skip) ==
+                 depth_of(h_skip) - depth_of(h_skip_skip)) {
+        skip = h_skip_skip;
+    }
+}
+
+size_t NodePacketHistory::depth_of(const NodePacketHistory *nph) {
+    return nph ? nph->depth : 0;
+}
+
+/**
+ * Returns the ancestor (prefix) of nph with the given depth, which should not
+ * be greater than that of nph. A null ancestor means the empty history.
+ */
+const NodePacketHistory *
+NodePacketHistory::ancestor(const NodePacketHistory *nph, size_t depth) {
+    while (depth_of(nph) > depth) {
+        if (depth_of(nph->skip) >= depth) {
+            nph = nph->skip;
+        } else {
+            nph = nph->past_hist;
+        }
+    }
+    return nph;
+}
 
 std::list<Packet *> NodePacketHistory::get_packets() const {
     std::list<Packet *> packets;
@@ -25,11 +60,7 @@ NodePacketHistory::get_packets_since(NodePacketHistory *start) const {
 }
 
 bool NodePacketHistory::contains(NodePacketHistory *other) const {
-    const NodePacketHistory *nph = this;
-    while (nph && nph != other) {
-        nph = nph->past_hist;
-    }
-    return nph == other;
+    return depth_of(other) <= depth && ancestor(this, depth_of(other)) == other;
 }
 
 bool operator==(const NodePacketHistory &a, const NodePacketHistory &b) {
@@ -41,21 +72,37 @@ bool operator==(const NodePacketHistory &a, const NodePacketHistory &b) {
 PacketHistory::PacketHistory(const Network &network) {
     for (const auto &[_, node] : network.nodes()) {
         if (node->is_emulated()) {
-            tbl.emplace(node, nullptr);
+            tbl.assign(node, nullptr);
+            _hash += entry_hash(node, nullptr);
         }
     }
 }
 
+size_t PacketHistory::entry_hash(Node *node, NodePacketHistory *nph) {
+    size_t value = std::hash<Node *>()(node);
+    ::hash::hash_combine(value, std::hash<NodePacketHistory *>()(nph));
+    return ::hash::mix(value);
+}
+
 void PacketHistory::set_node_pkt_hist(Node *node, NodePacketHistory *nph) {
-    tbl[node] = nph;
+    NodePacketHistory *const *old_nph = tbl.find(node);
+    if (old_nph) {
+        _hash -= entry_hash(node, *old_nph);
+    }
+    tbl.assign(node, nph);
+    _hash += entry_hash(node, nph);
 }
 
 NodePacketHistory *PacketHistory::get_node_pkt_hist(Node *node) {
-    return tbl.at(node);
+    NodePacketHistory *const *nph = tbl.find(node);
+    if (!nph) {
+        logger.error("No packet history of " + node->to_string());
+    }
+    return *nph;
 }
 
 bool operator==(const PacketHistory &a, const PacketHistory &b) {
-    return a.tbl == b.tbl;
+    return a._hash == b._hash && a.tbl == b.tbl;
 }
 
 /******************************************************************************/
@@ -93,28 +140,30 @@ bool NodePacketHistoryComp::operator()(NodePacketHistory *const &a,
         return false;
     }
 
-    std::list<Packet *> a_pkts = a->get_packets();
-    std::list<Packet *> b_pkts = b->get_packets();
+    // Lexicographical order of the packets, where a prefix comes first
+    const size_t depth = std::min(a->depth, b->depth);
+    const NodePacketHistory *x = NodePacketHistory::ancestor(a, depth);
+    const NodePacketHistory *y = NodePacketHistory::ancestor(b, depth);
+    if (x == y) {
+        return a->depth < b->depth;
+    }
 
-    for (auto a_it = a_pkts.begin(), b_it = b_pkts.begin();
-         a_it != a_pkts.end() && b_it != b_pkts.end(); ++a_it, ++b_it) {
-        if (*a_it != *b_it) {
-            return *a_it < *b_it;
+    // Find the first differing packets, right after the longest common prefix.
+    // Histories of the same depth have skips of the same length.
+    while (x->past_hist != y->past_hist) {
+        if (x->skip != y->skip) {
+            x = x->skip;
+            y = y->skip;
+        } else {
+            x = x->past_hist;
+            y = y->past_hist;
         }
     }
-
-    return a_pkts.size() < b_pkts.size();
+    return x->last_pkt < y->last_pkt;
 }
 
 size_t PacketHistoryHash::operator()(PacketHistory *const &ph) const {
-    size_t value = 0;
-    std::hash<Node *> node_hf;
-    std::hash<NodePacketHistory *> nph_hf;
-    for (const auto &entry : ph->tbl) {
-        ::hash::hash_combine(value, node_hf(entry.first));
-        ::hash::hash_combine(value, nph_hf(entry.second));
-    }
-    return value;
+    return ph->_hash;
 }
 
 bool PacketHistoryEq::operator()(PacketHistory *const &a,
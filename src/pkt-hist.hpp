@@ -1,9 +1,10 @@
 #pragma once
 
 #include <list>
-#include <unordered_map>
 
 #include "lib/hash.hpp"
+#include "lib/idmap.hpp"
+#include "lib/persistent-map.hpp"
 #include "network.hpp"
 #include "node.hpp"
 #include "packet.hpp"
@@ -13,11 +14,24 @@
  * represented as the "state" of that node.
  *
  * A (NodePacketHistory *) being null means empty history.
+ *
+ * Each history also keeps its depth (number of packets) and a skip pointer to
+ * an earlier history, laid out as in skew-binary random-access lists, so that
+ * the ancestor at any depth is found in O(log n) steps. Since the histories
+ * are interned, two histories share a prefix if and only if they share the
+ * ancestor at its depth, which makes ancestry checks and ordering O(log n)
+ * without materializing the packets.
  */
 class NodePacketHistory {
 private:
     Packet *last_pkt;
     NodePacketHistory *past_hist;
+    NodePacketHistory *skip; // an earlier history, or null
+    size_t depth;            // number of packets
+
+    static size_t depth_of(const NodePacketHistory *);
+    static const NodePacketHistory *ancestor(const NodePacketHistory *,
+                                             size_t depth);
 
     friend struct NodePacketHistoryHash;
     friend struct NodePacketHistoryComp;
@@ -36,11 +50,15 @@ bool operator==(const NodePacketHistory &, const NodePacketHistory &);
 
 /**
  * PacketHistory contains the packet traversal history (of each node) for the
- * whole network of the current EC.
+ * whole network of the current EC. It is a persistent map, so a copy with one
+ * node's history changed shares the rest with the original.
  */
-class PacketHistory {
+class PacketHistory : public DenseID {
 private:
-    std::unordered_map<Node *, NodePacketHistory *> tbl;
+    PersistentMap<Node *, NodePacketHistory *> tbl;
+    size_t _hash = 0; // sum of the mixed hashes of the entries
+
+    static size_t entry_hash(Node *, NodePacketHistory *);
 
     friend struct PacketHistoryHash;
     friend bool operator==(const PacketHistory &, const PacketHistory &);
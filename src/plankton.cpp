@@ -1,38 +1,76 @@
 #include "plankton.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <fcntl.h>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <poll.h>
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <sstream>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
 
+#include "baseline.hpp"
 #include "configparser.hpp"
 #include "dropdetection.hpp"
 #include "dropmon.hpp"
 #include "droptimeout.hpp"
 #include "droptrace.hpp"
+#include "ecpriority.hpp"
 #include "emulationmgr.hpp"
 #include "eqclassmgr.hpp"
+#include "fibmgr.hpp"
+#include "injection-cache.hpp"
+#include "jobserver.hpp"
+#include "journal.hpp"
+#include "lib/hash.hpp"
 #include "logger.hpp"
 #include "model-access.hpp"
+#include "modelmgr.hpp"
 #include "payloadmgr.hpp"
+#include "protocols.hpp"
 #include "stats.hpp"
 #include "unique-storage.hpp"
 
 using namespace std;
+using namespace rapidjson;
 namespace fs = std::filesystem;
 
 bool Plankton::_all_ecs = false;
 bool Plankton::_parallel_invs = false;
 bool Plankton::_violated = false;
+bool Plankton::_ec_violated = false;
 bool Plankton::_terminate = false;
 unordered_set<pid_t> Plankton::_tasks;
+unordered_map<pid_t, pair<size_t, size_t>> Plankton::_ec_tasks;
+set<size_t> Plankton::_conns_exceeded;
 const int Plankton::sigs[] = {SIGCHLD, SIGUSR1, SIGHUP,
                               SIGINT,  SIGQUIT, SIGTERM};
 
-Plankton::Plankton() : _max_jobs(0), _max_emu(0) {}
+Plankton::Plankton() :
+    _symmetry(false),
+    _prioritize(false),
+    _swarm(1),
+    _sample(0),
+    _sample_fraction(0),
+    _shard(0),
+    _num_shards(1),
+    _max_jobs(0),
+    _max_emu(0),
+    _search_mode(SEARCH_EXHAUSTIVE),
+    _mem_per_job(0),
+    _ec_idx(0),
+    _swarm_member(0),
+    _spin_hash_bits(0),
+    _spin_max_depth(0) {}
 
 Plankton::~Plankton() {
     reset(/* destruct */ true);
@@ -43,35 +81,157 @@ Plankton &Plankton::get() {
     return instance;
 }
 
-void Plankton::init(bool all_ecs,
-                    bool parallel_invs,
-                    size_t max_jobs,
-                    size_t max_emu,
-                    const string &drop_method,
-                    const string &input_file,
-                    const string &output_dir) {
+// Returns the available memory in bytes (MemAvailable of /proc/meminfo)
+static size_t available_memory() {
+    ifstream ifs("/proc/meminfo");
+    string line;
+
+    while (getline(ifs, line)) {
+        if (line.starts_with("MemAvailable:")) {
+            return stoul(line.substr(13)) * 1024;
+        }
+    }
+
+    return sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+}
+
+// Returns the number of a member of a JSON object written by Neo
+static double json_number(const Value &obj, const char *key) {
+    if (!obj.IsObject() || !obj.HasMember(key) || !obj[key].IsNumber()) {
+        logger.error("Missing " + string(key) + " in the plan");
+    }
+    return obj[key].GetDouble();
+}
+
+// Writes the JSON text in the buffer into the file
+static void write_json(const StringBuffer &buffer, const fs::path &path) {
+    ofstream ofs(path);
+    if (!ofs) {
+        logger.error("Failed to open " + path.string());
+    }
+    ofs << buffer.GetString() << endl;
+}
+
+// Returns the connections of the current EC in one line
+static string conns_line(const Invariant &inv) {
+    string ret;
+    for (const Connection &conn : inv.all_conns()) {
+        ret += (ret.empty() ? "" : "; ") + conn.to_string();
+    }
+    return ret;
+}
+
+/**
+ * Returns the description of the invariant in one line, where the unordered
+ * items within brackets are sorted, so that it can be matched across runs.
+ */
+static string inv_key(const Invariant &inv) {
+    const string desc = inv.to_string();
+    string ret;
+    size_t pos = 0;
+
+    for (size_t lb; (lb = desc.find('[', pos)) != string::npos;) {
+        const size_t rb = desc.find(']', lb);
+        if (rb == string::npos) {
+            break;
+        }
+
+        istringstream iss(desc.substr(lb + 1, rb - lb - 1));
+        vector<string> items{istream_iterator<string>(iss),
+                             istream_iterator<string>()};
+        sort(items.begin(), items.end());
+        ret += desc.substr(pos, lb - pos) + "[";
+        for (const string &item : items) {
+            ret += " " + item;
+        }
+        ret += " ]";
+        pos = rb + 1;
+    }
+    ret += desc.substr(pos);
+
+    for (size_t nl; (nl = ret.find('\n')) != string::npos;) {
+        ret.replace(nl, 1, "; ");
+    }
+    return ret;
+}
+
+void Plankton::init(const PlanktonOptions &opts) {
     // Initialize system-wide configuration
-    this->_all_ecs = all_ecs;
-    this->_parallel_invs = parallel_invs;
-    this->_max_jobs = min(max_jobs, size_t(thread::hardware_concurrency()));
-    this->_max_emu = max_emu;
-    this->_drop_method = drop_method;
-    fs::create_directories(output_dir);
-    this->_in_file = fs::canonical(input_file);
-    this->_out_dir = fs::canonical(output_dir);
+    // The violation rate of a sample is only known if all of it is verified
+    this->_all_ecs =
+        opts.all_ecs || opts.sample > 0 || opts.sample_fraction > 0;
+    this->_parallel_invs = opts.parallel_invs;
+    this->_symmetry = opts.symmetry;
+    this->_prioritize = opts.prioritize;
+    this->_swarm = opts.swarm;
+    this->_sample = opts.sample;
+    this->_sample_fraction = opts.sample_fraction;
+    this->_shard = opts.shard;
+    this->_num_shards = opts.num_shards;
+    // Tasks may oversubscribe the CPUs only if the concurrency is adaptive
+    this->_max_jobs =
+        opts.adaptive_jobs
+            ? opts.max_jobs
+            : min(opts.max_jobs, size_t(thread::hardware_concurrency()));
+    this->_max_emu = opts.max_emu;
+    this->_drop_method = opts.drop_method;
+    this->_engine = opts.engine;
+    this->_mem_per_job = available_memory() / _max_jobs;
+    fs::create_directories(opts.output_dir);
+    this->_in_file = fs::canonical(opts.input_file);
+    this->_out_dir = fs::canonical(opts.output_dir);
     logger.enable_console_logging();
     logger.enable_file_logging(fs::path(_out_dir) / "main.log");
+    _journal.open(_out_dir, opts.resume);
 
     // Parse and load the input configurations
     ConfigParser().parse(_in_file, *this);
 
+    // Diff the network against the baseline run, and snapshot it for later runs
+    if (!opts.baseline_dir.empty()) {
+        _baseline.load(opts.baseline_dir, _network, _openflow);
+    }
+    Baseline::write_snapshot(_out_dir, _network, _openflow);
+
     // Initialize system-wide configurations
     if (this->_max_emu == 0) {
         this->_max_emu = _network.middleboxes().size();
     }
 
+    // The order of connections matters to openflow updates
+    bool por = opts.por;
+    if (por && _openflow.num_nodes() > 0) {
+        logger.info("Partial-order reduction is disabled with openflow updates");
+        por = false;
+    }
+    _choose_conn.init(_network, por);
+
     EmulationMgr::get().max_emulations(_max_emu);
     DropTimeout::get().init();
+    if (opts.adaptive_jobs) {
+        size_t jobs = clamp(size_t(thread::hardware_concurrency()),
+                            opts.min_jobs, _max_jobs);
+        JobServer::get().init(jobs);
+        _job_ctl.init(opts.min_jobs, _max_jobs, jobs);
+    } else {
+        JobServer::get().init(_max_jobs);
+    }
+    injection_cache.init_shared(SHARED_INJ_CACHE_SLOTS, SHARED_INJ_CACHE_ARENA);
+    if (!opts.cache_dir.empty()) {
+        injection_cache.open_store(opts.cache_dir);
+    }
+    ModelMgr::get().init(
+        fs::path(opts.cache_dir.empty() ? _out_dir : opts.cache_dir) / "models");
+
+    if (opts.search_mode == "collapse") {
+        _search_mode = SEARCH_COLLAPSE;
+    } else if (opts.search_mode == "hashcompact") {
+        _search_mode = SEARCH_HASHCOMPACT;
+    } else if (opts.search_mode == "bitstate") {
+        _search_mode = SEARCH_BITSTATE;
+    } else {
+        _search_mode = SEARCH_EXHAUSTIVE;
+    }
 
     if (_drop_method == "dropmon") {
         drop = &DropMon::get();
@@ -95,8 +255,17 @@ void Plankton::init(bool all_ecs,
 // Reset to as if it was just constructed
 void Plankton::reset(bool destruct) {
     this->_all_ecs = false;
+    this->_symmetry = false;
+    this->_prioritize = false;
+    this->_swarm = 1;
+    this->_sample = 0;
+    this->_sample_fraction = 0;
+    this->_shard = 0;
+    this->_num_shards = 1;
     this->_max_jobs = 0;
     this->_max_emu = 0;
+    this->_search_mode = SEARCH_EXHAUSTIVE;
+    this->_mem_per_job = 0;
     this->_in_file.clear();
     this->_out_dir.clear();
     this->_network.reset();
@@ -104,32 +273,44 @@ void Plankton::reset(bool destruct) {
     this->_choose_conn.reset();
     this->_forwarding.reset();
     this->_openflow.reset();
+    this->_job_ctl.reset();
+    this->_journal.reset();
+    this->_baseline.reset();
     this->_inv.reset();
     this->_violated = false;
+    this->_ec_violated = false;
+    this->_ec_idx = 0;
+    this->_swarm_member = 0;
+    this->_explorer.reset();
     this->_terminate = false;
     this->kill_all_tasks(SIGKILL);
     this->_tasks.clear();
+    this->_ec_tasks.clear();
+    this->_conns_exceeded.clear();
 
     // Reset system-wide configurations
     // During program destruction, these singletons will get destroyed
     // automatically, so we don't reset them to avoid use after free.
     if (!destruct) {
         EmulationMgr::get().reset();
+        JobServer::get().reset();
+        FIBMgr::get().reset();
         EqClassMgr::get().reset();
         DropTimeout::get().reset();
         DropMon::get().stop();
         DropMon::get().teardown();
         DropTrace::get().teardown();
         PayloadMgr::get().reset();
+        injection_cache.reset();
         model.reset();
+        ModelMgr::get().reset();
         storage.reset();
         drop = nullptr;
         _STATS_RESET();
     }
 }
 
-int Plankton::run() {
-    // Register signal handler
+void Plankton::register_inv_sig_handler() {
     struct sigaction action;
     action.sa_sigaction = inv_sig_handler;
     sigemptyset(&action.sa_mask);
@@ -140,6 +321,10 @@ int Plankton::run() {
     for (size_t i = 0; i < sizeof(sigs) / sizeof(int); ++i) {
         sigaction(sigs[i], &action, nullptr);
     }
+}
+
+int Plankton::run() {
+    register_inv_sig_handler();
 
     DropMon::get().start(); // Start kernel drop_monitor (if enabled)
 
@@ -163,7 +348,7 @@ int Plankton::run() {
                 (this->_parallel_invs &&
                  this->_tasks.size() >= this->_max_jobs)) &&
                !this->_terminate) {
-            pause();
+            wait_tasks();
         }
 
         if (this->_terminate) {
@@ -172,9 +357,10 @@ int Plankton::run() {
     }
 
     while (!this->_tasks.empty() && !this->_terminate) {
-        pause();
+        wait_tasks();
     }
 
+    _journal.sync(/* force */ true);
     _STATS_STOP(Stats::Op::MAIN_PROC);
     _STATS_LOGRESULTS(Stats::Op::MAIN_PROC);
 
@@ -182,6 +368,216 @@ int Plankton::run() {
     return 0;
 }
 
+/**
+ * Plans the verification (`--plan`) without verifying any EC. Like `run()`, it
+ * forks for each invariant, in parallel up to the max number of jobs, to
+ * compute the invariant-aware ECs, the data planes, and the connection matrix,
+ * and to estimate the cost of the ECs to verify. The estimates are collected
+ * into `plan.json` in the output directory.
+ */
+int Plankton::plan() {
+    register_inv_sig_handler();
+
+    for (const auto &inv : _invs) {
+        pid_t childpid;
+
+        if ((childpid = fork()) < 0) {
+            logger.error("fork()", errno);
+        } else if (childpid == 0) {
+            this->_inv = inv;
+            plan_invariant();
+            exit(0);
+        }
+
+        this->_tasks.insert(childpid);
+
+        while (this->_tasks.size() >= this->_max_jobs && !this->_terminate) {
+            wait_tasks();
+        }
+
+        if (this->_terminate) {
+            break;
+        }
+    }
+
+    while (!this->_tasks.empty() && !this->_terminate) {
+        wait_tasks();
+    }
+
+    if (this->_terminate) {
+        return 1;
+    }
+
+    // Collect the plans of all invariants
+    vector<Document> plans(_invs.size());
+    uint64_t num_ecs = 0, num_to_verify = 0;
+    double injections = 0, cpu_time = 0, wall_time = 0, max_wall_time = 0;
+
+    for (size_t i = 0; i < _invs.size(); ++i) {
+        const auto path =
+            fs::path(_out_dir) / to_string(_invs[i]->id()) / "plan.json";
+        ifstream ifs(path);
+        if (!ifs) {
+            logger.error("Failed to open " + path.string());
+        }
+
+        const string json{istreambuf_iterator<char>(ifs),
+                          istreambuf_iterator<char>()};
+        Document &inv_plan = plans[i];
+        if (inv_plan.Parse(json.c_str()).HasParseError()) {
+            logger.error("Malformed plan " + path.string());
+        }
+
+        num_ecs += json_number(inv_plan, "connection_ecs");
+        num_to_verify += json_number(inv_plan, "ecs_to_verify");
+        injections += json_number(inv_plan, "expected_injections");
+        cpu_time += json_number(inv_plan, "estimated_cpu_time_usec");
+        const double inv_wall_time =
+            json_number(inv_plan, "estimated_wall_time_usec");
+        wall_time += inv_wall_time;
+        max_wall_time = max(max_wall_time, inv_wall_time);
+    }
+
+    // Invariants verified in parallel share the jobs
+    if (_parallel_invs) {
+        wall_time = max(cpu_time / _max_jobs, max_wall_time);
+    }
+
+    StringBuffer buffer;
+    PrettyWriter<StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("jobs");
+    writer.Uint64(_max_jobs);
+    writer.Key("latency_usec");
+    writer.Int64(DropTimeout::get().lat_avg().count());
+    writer.Key("invariants");
+    writer.StartArray();
+    for (const Document &inv_plan : plans) {
+        inv_plan.Accept(writer);
+    }
+    writer.EndArray();
+    writer.Key("total");
+    writer.StartObject();
+    writer.Key("connection_ecs");
+    writer.Uint64(num_ecs);
+    writer.Key("ecs_to_verify");
+    writer.Uint64(num_to_verify);
+    writer.Key("expected_injections");
+    writer.Double(injections);
+    writer.Key("estimated_cpu_time_usec");
+    writer.Double(cpu_time);
+    writer.Key("estimated_wall_time_usec");
+    writer.Double(wall_time);
+    writer.EndObject();
+    writer.EndObject();
+
+    const auto path = fs::path(_out_dir) / "plan.json";
+    write_json(buffer, path);
+
+    logger.info("Connection ECs to verify: " + to_string(num_to_verify) +
+                ", estimated wall time: " + to_string(wall_time / 1e6) +
+                " sec");
+    logger.info("Plan written to " + path.string());
+    return 0;
+}
+
+// Number of packets exchanged by a connection of the protocol
+static size_t num_pkts(int protocol) {
+    switch (protocol) {
+    case proto::tcp:
+        return PS_TCP_TERM_3 - PS_TCP_INIT_1 + 1;
+    case proto::udp:
+        return PS_UDP_REP - PS_UDP_REQ + 1;
+    default:
+        return PS_ICMP_ECHO_REP - PS_ICMP_ECHO_REQ + 1;
+    }
+}
+
+/**
+ * Estimates the cost of the ECs of the current invariant to verify from their
+ * forwarding paths: every packet of a connection is injected into each emulated
+ * middlebox along the paths, and each injection takes the calibrated latency.
+ * The state space explored between injections is not accounted for.
+ */
+void Plankton::plan_invariant() {
+    const auto inv_dir = fs::path(_out_dir) / to_string(_inv->id());
+    fs::create_directory(inv_dir);
+
+    this->_inv->update_ecs();
+    FIBMgr::get().precompute(EqClassMgr::get().all_ecs(), _network, _openflow,
+                             _max_jobs);
+    this->_inv->compute_conn_matrix(_symmetry);
+
+    const size_t num_ecs = _inv->num_conn_ecs();
+    const vector<size_t> ec_indices = sample_ecs(num_ecs);
+    const double lat = DropTimeout::get().lat_avg().count();
+    size_t max_length = 0, total_length = 0, max_mbs = 0, total_mbs = 0;
+    double injections = 0, max_time = 0;
+
+    for (size_t i : ec_indices) {
+        _inv->set_conns(i);
+        size_t length = 0, mbs = 0;
+        double ec_injections = 0;
+
+        for (const Connection &conn : _inv->all_conns()) {
+            const ECPriority::Paths paths = ECPriority::trace(conn);
+            length = max(length, paths.length);
+            mbs += paths.middleboxes;
+            ec_injections += num_pkts(conn.get_protocol()) * paths.middleboxes;
+        }
+
+        max_length = max(max_length, length);
+        total_length += length;
+        max_mbs = max(max_mbs, mbs);
+        total_mbs += mbs;
+        injections += ec_injections * _swarm;
+        max_time = max(max_time, ec_injections * lat);
+    }
+
+    const double cpu_time = injections * lat;
+    const size_t n = max<size_t>(ec_indices.size(), 1);
+    StringBuffer buffer;
+    PrettyWriter<StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("id");
+    writer.Int(_inv->id());
+    writer.Key("invariant");
+    writer.String(inv_key(*_inv).c_str());
+    writer.Key("connection_ecs");
+    writer.Uint64(num_ecs);
+    writer.Key("ecs_to_verify");
+    writer.Uint64(ec_indices.size());
+    writer.Key("max_path_length");
+    writer.Uint64(max_length);
+    writer.Key("avg_path_length");
+    writer.Double(double(total_length) / n);
+    writer.Key("max_middlebox_touches");
+    writer.Uint64(max_mbs);
+    writer.Key("avg_middlebox_touches");
+    writer.Double(double(total_mbs) / n);
+    writer.Key("expected_injections");
+    writer.Double(injections);
+    writer.Key("estimated_cpu_time_usec");
+    writer.Double(cpu_time);
+    writer.Key("estimated_wall_time_usec");
+    writer.Double(max(max_time, cpu_time / _max_jobs));
+    writer.EndObject();
+    write_json(buffer, inv_dir / "plan.json");
+}
+
+/**
+ * Waits for a signal from the invariant tasks. With adaptive concurrency, the
+ * main process also wakes up periodically to update the job controller.
+ */
+void Plankton::wait_tasks() {
+    if (_job_ctl.enabled()) {
+        poll(nullptr, 0, 500);
+        _job_ctl.update();
+    } else {
+        pause();
+    }
+}
+
 /**
  * This signal handler is used by both the main process and the invariant
  * processes.
@@ -197,13 +593,29 @@ void Plankton::inv_sig_handler(int sig,
 
         while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
             _tasks.erase(pid);
-
-            if (WIFEXITED(status) && (rc = WEXITSTATUS(status)) != 0) {
+            release_job();
+
+            auto it = _ec_tasks.find(pid);
+            if (WIFEXITED(status) &&
+                WEXITSTATUS(status) == EXIT_CONNS_EXCEEDED &&
+                it != _ec_tasks.end()) {
+                // The EC is verified again once the others are finished
+                _conns_exceeded.insert(it->second.first);
+                kill_swarm(pid);
+            } else if (WIFEXITED(status) &&
+                       (rc = WEXITSTATUS(status)) != 0) {
                 // A task exited abnormally. Halt all verification tasks.
                 logger.warn("Process " + to_string(pid) + " exited " +
                             to_string(rc));
                 kill_all_tasks(SIGTERM);
                 _terminate = true;
+            } else if (it != _ec_tasks.end()) {
+                // The exhaustive member has finished the search of the EC
+                if (it->second.second == 0) {
+                    kill_swarm(pid);
+                } else {
+                    _ec_tasks.erase(it);
+                }
             }
         }
         break;
@@ -212,10 +624,15 @@ void Plankton::inv_sig_handler(int sig,
         // Invariant violated. Stop all remaining tasks
         pid = siginfo->si_pid;
         logger.warn("Invariant violated in process " + to_string(pid));
+        if (!_violated) {
+            Stats::get().mark_violation();
+        }
         _violated = true;
 
         if (!_all_ecs) {
             kill_all_tasks(SIGTERM, /* exclude */ pid);
+        } else {
+            kill_swarm(pid);
         }
 
         break;
@@ -224,6 +641,7 @@ void Plankton::inv_sig_handler(int sig,
     case SIGINT:
     case SIGQUIT:
     case SIGTERM: {
+        // The journal is flushed once the main loop sees _terminate
         logger.warn("Killed");
         kill_all_tasks(sig);
         _terminate = true;
@@ -232,6 +650,16 @@ void Plankton::inv_sig_handler(int sig,
     }
 }
 
+/**
+ * Returns the job token of a reaped EC task to the jobserver. The invariant
+ * tasks of the main process don't hold any token.
+ */
+void Plankton::release_job() {
+    if (get()._inv) {
+        JobServer::get().release();
+    }
+}
+
 void Plankton::kill_all_tasks(int sig, pid_t exclude_pid) {
     if (exclude_pid) {
         _tasks.erase(exclude_pid);
@@ -241,10 +669,199 @@ void Plankton::kill_all_tasks(int sig, pid_t exclude_pid) {
         kill(pid, sig);
     }
 
-    while (wait(nullptr) != -1 || errno != ECHILD)
-        ;
+    pid_t pid;
+    while ((pid = wait(nullptr)) != -1 || errno != ECHILD) {
+        if (pid > 0) {
+            release_job();
+        }
+    }
 
     _tasks.clear();
+    _ec_tasks.clear();
+}
+
+/**
+ * Stops the other swarm members verifying the same EC as the given task, which
+ * has found a counterexample or finished the search. The stopped members are
+ * reaped by the SIGCHLD handler later.
+ */
+void Plankton::kill_swarm(pid_t pid) {
+    auto it = _ec_tasks.find(pid);
+    if (it == _ec_tasks.end()) {
+        return;
+    }
+
+    const size_t ec_idx = it->second.first;
+    _ec_tasks.erase(it);
+
+    for (it = _ec_tasks.begin(); it != _ec_tasks.end();) {
+        if (it->second.first == ec_idx) {
+            kill(it->first, SIGTERM);
+            it = _ec_tasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Returns the indices of the connection ECs of the current invariant to verify,
+ * which are all the ECs unless sampling (`--sample`, `--sample-fraction`). The
+ * sample is seeded by the invariant ID, so that it stays the same across runs
+ * for resuming, baselines, and shards. With `--shard k/n`, only every n-th of
+ * them starting from the (k-1)-th is verified, so that independent runs split
+ * the ECs without any coordination.
+ */
+vector<size_t> Plankton::sample_ecs(size_t num_ecs) const {
+    size_t n = num_ecs;
+    if (_sample > 0) {
+        n = _sample;
+    } else if (_sample_fraction > 0) {
+        n = max(size_t(ceil(_sample_fraction * num_ecs)), size_t(1));
+    }
+
+    vector<size_t> ec_indices;
+    if (n >= num_ecs) {
+        for (size_t i = _shard; i < num_ecs; i += _num_shards) {
+            ec_indices.push_back(i);
+        }
+    } else {
+        const vector<size_t> sample = _inv->sample_conn_ecs(n, _inv->id());
+        for (size_t i = _shard; i < sample.size(); i += _num_shards) {
+            ec_indices.push_back(sample[i]);
+        }
+    }
+    return ec_indices;
+}
+
+/**
+ * Logs the connections represented by the violated representatives of symmetric
+ * connections (`--symmetry`), according to the journal, since they are violated
+ * as well.
+ */
+void Plankton::report_symmetric() const {
+    const auto invs = Journal::read(fs::path(_out_dir) / "journal");
+    auto inv_it = invs.find(_inv->id());
+    if (inv_it == invs.end()) {
+        return;
+    }
+
+    for (const auto &[ec_idx, res] : inv_it->second.results) {
+        if (!res.violated) {
+            continue;
+        }
+        for (const auto &members : _inv->represented_conns(ec_idx)) {
+            if (members.size() <= 1) {
+                continue;
+            }
+            logger.warn(members[0].to_string() +
+                        " violated, which represents " +
+                        to_string(members.size()) + " symmetric connections:");
+            for (const Connection &conn : members) {
+                logger.warn("  " + conn.to_string());
+            }
+        }
+    }
+}
+
+/**
+ * Returns the upper bound of the 95% confidence interval of the violation rate
+ * over num_ecs ECs, of which a sample of n ECs has the given violations (Wilson
+ * score interval, with the finite population correction).
+ */
+double Plankton::violation_rate_bound(size_t violated,
+                                      size_t n,
+                                      size_t num_ecs) {
+    const double z = 1.96;
+    const double p = double(violated) / n;
+    const double fpc = num_ecs > 1 ? sqrt(double(num_ecs - n) / (num_ecs - 1))
+                                   : 0;
+    const double z2 = z * z * fpc * fpc;
+    const double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    const double margin =
+        sqrt(z2 * (p * (1 - p) / n + z2 / (4.0 * n * n))) / (1 + z2 / n);
+    return min(center + margin, 1.0);
+}
+
+/**
+ * Logs the violation rate of the sampled ECs, according to the journal, with
+ * the upper bound of its 95% confidence interval over all the ECs of the
+ * invariant.
+ */
+void Plankton::report_sample(const vector<size_t> &ec_sample,
+                             size_t num_ecs) const {
+    const auto invs = Journal::read(fs::path(_out_dir) / "journal");
+    auto inv_it = invs.find(_inv->id());
+    size_t n = 0, violated = 0;
+
+    for (size_t i : ec_sample) {
+        if (inv_it == invs.end()) {
+            break;
+        }
+        auto it = inv_it->second.results.find(i);
+        if (it != inv_it->second.results.end()) {
+            ++n;
+            violated += it->second.violated;
+        }
+    }
+
+    if (n == 0) {
+        return;
+    }
+
+    const double p = double(violated) / n;
+    const double upper = violation_rate_bound(violated, n, num_ecs);
+
+    logger.info("Sampled ECs violated: " + to_string(violated) + " of " +
+                to_string(n) + " (rate " + to_string(p) + ", <= " +
+                to_string(upper) + " with 95% confidence, ~" +
+                to_string(size_t(ceil(upper * num_ecs))) + " of " +
+                to_string(num_ecs) + " ECs)");
+}
+
+/**
+ * Returns the indices of the unfinished connection ECs of the current invariant
+ * in the order of verification. With `--prioritize`, the ECs are sorted by
+ * their scores in descending order (see ECPriority), where ties keep the order
+ * of the connection matrix.
+ */
+vector<size_t> Plankton::ec_order(const vector<size_t> &ec_sample,
+                                  const string &inv_desc) {
+    vector<size_t> ec_indices;
+    for (size_t i : ec_sample) {
+        if (!_journal.finished(_inv->id(), i)) {
+            ec_indices.push_back(i);
+        }
+    }
+
+    // Correlated invariants don't have their own connections to score
+    _inv->set_conns(0);
+    if (!_prioritize || ec_indices.size() < 2 || _inv->conns().empty()) {
+        return ec_indices;
+    }
+
+    vector<pair<ECPriority::Score, size_t>> scores;
+    for (size_t i : ec_indices) {
+        _inv->set_conns(i);
+        const Journal::Result *res =
+            _baseline.result(inv_desc, conns_line(*_inv));
+        scores.emplace_back(
+            ECPriority::score(_inv->conns(), res && res->violated), i);
+    }
+    stable_sort(scores.begin(), scores.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+
+    for (size_t i = 0; i < scores.size(); ++i) {
+        ec_indices[i] = scores[i].second;
+    }
+    const ECPriority::Score &top = scores.front().first;
+    logger.info("Prioritized ECs, top score: violated before " +
+                to_string(top.violated_before) + ", middleboxes " +
+                to_string(top.middleboxes) + ", openflow updates " +
+                to_string(top.of_updates) + ", branches " +
+                to_string(top.branches));
+    return ec_indices;
 }
 
 void Plankton::verify_invariant() {
@@ -257,54 +874,221 @@ void Plankton::verify_invariant() {
     this->_violated = false;
     this->_tasks.clear();
 
+    // Precompute the data planes of all ECs before forking
+    this->_inv->update_ecs();
+    FIBMgr::get().precompute(EqClassMgr::get().all_ecs(), _network, _openflow,
+                             _max_jobs);
+
     // Compute connection matrix (Cartesian product)
-    this->_inv->compute_conn_matrix();
+    this->_inv->compute_conn_matrix(_symmetry);
+
+    // Load the model variant specialized to the invariant. A connection may be
+    // translated into a new one at each middlebox along the path. It may be
+    // translated more than once by the same middlebox though (e.g., on a looped
+    // path), so the ECs exceeding the variant are verified again afterwards
+    // with the static number of connections (see exceed_max_conns).
+    uint32_t features = _inv->model_features();
+    if (_openflow.num_nodes() > 0) {
+        features |= MODEL_OPENFLOW_UPDATE_STATE;
+    }
+    size_t max_conns =
+        _inv->num_concurrent_conns() * (1 + _network.middleboxes().size());
+    model.set_variant(ModelMgr::get().load(max_conns, features, _search_mode));
+    size_search();
+
+    // Skip the ECs that have been finished by a previous run
+    const size_t num_ecs = _inv->num_conn_ecs();
+    const string inv_desc = inv_key(*_inv);
+    _journal.begin_invariant(_inv->id(), num_ecs, inv_desc);
+    _journal.discard_mismatched(_inv->id(), [this](size_t i) {
+        _inv->set_conns(i);
+        return conns_line(*_inv);
+    });
+
+    // ECs to verify: all of them, or a stratified random sample
+    const vector<size_t> ec_sample = sample_ecs(num_ecs);
+
+    // Carry over the results of the ECs unaffected since the baseline run
+    size_t num_carried = 0;
+    for (size_t i : ec_sample) {
+        if (!_baseline.loaded()) {
+            break;
+        } else if (_journal.finished(_inv->id(), i)) {
+            continue;
+        }
+        _inv->set_conns(i);
+        if (_inv->conns().empty()) {
+            break; // correlated invariants are always verified again
+        }
+        const Journal::Result *res =
+            _baseline.result(inv_desc, conns_line(*_inv));
+        if (res && !_baseline.affected(_inv->conns())) {
+            _journal.carry_over(_inv->id(), i, *res);
+            ++num_carried;
+        }
+    }
+
+    const size_t num_finished =
+        count_if(ec_sample.begin(), ec_sample.end(), [this](size_t i) {
+            return _journal.finished(_inv->id(), i);
+        });
 
     // Update latency estimate
-    int nprocs = min(this->_inv->num_conn_ecs(), _max_jobs);
+    int nprocs = min((ec_sample.size() - num_finished) * _swarm, _max_jobs);
     DropTimeout::get().adjust_latency_estimate_by_nprocs(nprocs);
 
     logger.info("====================");
     logger.info(to_string(_inv->id()) + ". Verifying invariant " +
                 _inv->to_string());
-    logger.info("Connection ECs: " + to_string(_inv->num_conn_ecs()));
+    logger.info("Connection ECs: " + to_string(num_ecs) +
+                (num_finished ? " (" + to_string(num_finished) +
+                                    " finished in the journal)"
+                              : ""));
+    if (ec_sample.size() < num_ecs) {
+        logger.info("Connection ECs to verify: " + to_string(ec_sample.size()) +
+                    (_num_shards > 1 ? " (shard " + to_string(_shard + 1) +
+                                           "/" + to_string(_num_shards) + ")"
+                                     : ""));
+    }
+    if (num_carried > 0) {
+        logger.info("Carried over from the baseline: " +
+                    to_string(num_carried));
+    }
 
-    _STATS_START(Stats::Op::CHECK_INVARIANT);
+    if (!_all_ecs && _journal.violated(_inv->id())) {
+        logger.warn("Invariant violated in the journal");
+        _violated = true;
+    }
 
-    // Fork for each combination of concurrent connections
-    while ((!_violated || _all_ecs) && !_terminate && _inv->set_conns()) {
-        pid_t childpid;
+    // Order of the unfinished ECs to verify
+    const vector<size_t> ec_indices = ec_order(ec_sample, inv_desc);
 
-        if ((childpid = fork()) < 0) {
-            logger.error("fork()", errno);
-        } else if (childpid == 0) {
-            verify_conn();
-            exit(0);
+    _STATS_START(Stats::Op::CHECK_INVARIANT);
+
+    // Fork for each combination of concurrent connections, and for each
+    // member of its swarm
+    for (size_t i = 0; i < ec_indices.size() * _swarm; ++i) {
+        if (!acquire_job()) {
+            break;
         }
+        fork_ec(ec_indices[i / _swarm], i % _swarm);
+    }
 
-        _tasks.insert(childpid);
+    while (!_tasks.empty() && !_terminate) {
+        pause();
+        _journal.sync();
+    }
+
+    // Verify the ECs that exceeded the connections of the model variant again,
+    // with as many connections as the static model and without swarm
+    if (!_conns_exceeded.empty() && !_terminate) {
+        const vector<size_t> retry_ecs(_conns_exceeded.begin(),
+                                       _conns_exceeded.end());
+        _conns_exceeded.clear();
+        model.set_variant(ModelMgr::get().load(neo_model_variant()->max_conns,
+                                               features, _search_mode));
+        size_search();
+        logger.warn("Verifying " + to_string(retry_ecs.size()) +
+                    " connection ECs again with " +
+                    to_string(model.get_max_conns()) + " connections");
+
+        for (size_t ec_idx : retry_ecs) {
+            if (!acquire_job()) {
+                break;
+            }
+            fork_ec(ec_idx, 0);
+        }
 
-        while (_tasks.size() >= _max_jobs && !_terminate) {
+        while (!_tasks.empty() && !_terminate) {
             pause();
+            _journal.sync();
         }
     }
 
-    while (!_tasks.empty() && !_terminate) {
-        pause();
+    _journal.sync(/* force */ true);
+
+    if (_symmetry && _violated && !_terminate) {
+        report_symmetric();
+    }
+
+    if ((_sample > 0 || _sample_fraction > 0) && !_terminate) {
+        report_sample(ec_sample, num_ecs);
     }
 
     _STATS_STOP(Stats::Op::CHECK_INVARIANT);
     _STATS_LOGRESULTS(Stats::Op::CHECK_INVARIANT);
 }
 
+/**
+ * Takes a job token for a new EC task, which may have been released by the EC
+ * tasks of any invariant. Returns false if no more EC tasks should be started.
+ */
+bool Plankton::acquire_job() const {
+    while ((!_violated || _all_ecs) && !_terminate) {
+        if (JobServer::get().acquire()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Forks an EC process for the EC, or a swarm member of it. SIGCHLD and SIGUSR1
+ * are blocked meanwhile, so that the handlers don't see the task before it is
+ * recorded.
+ */
+void Plankton::fork_ec(size_t ec_idx, size_t swarm_member) {
+    _inv->set_conns(ec_idx);
+
+    sigset_t mask, orig_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, &orig_mask);
+
+    pid_t childpid;
+
+    if ((childpid = fork()) < 0) {
+        logger.error("fork()", errno);
+    } else if (childpid == 0) {
+        sigprocmask(SIG_SETMASK, &orig_mask, nullptr);
+        _ec_idx = ec_idx;
+        _swarm_member = swarm_member;
+        verify_conn();
+        exit(0);
+    }
+
+    _tasks.insert(childpid);
+    _ec_tasks.emplace(childpid, make_pair(ec_idx, swarm_member));
+    sigprocmask(SIG_SETMASK, &orig_mask, nullptr);
+    _journal.sync();
+}
+
 void Plankton::verify_conn() {
+    init_ec_process(to_string(getpid()));
+
+    // Swarm members other than the first one bound their search depth
+    if (_swarm_member > 0) {
+        _spin_max_depth = max(_spin_max_depth >> ((_swarm_member - 1) % 3),
+                              size_t(1000));
+        logger.info("Swarm member " + to_string(_swarm_member) + " of EC " +
+                    to_string(_ec_idx) + " (max depth " +
+                    to_string(_spin_max_depth) + ")");
+    }
+
+    _STATS_START(Stats::Op::CHECK_EC);
+    run_engine(to_string(getpid()) + ".trail");
+    logger.error("verify_exit isn't called by Spin");
+}
+
+void Plankton::init_ec_process(const string &log_name) {
     // Change to the invariant output directory
     const auto inv_dir = fs::path(_out_dir) / to_string(_inv->id());
     fs::create_directory(inv_dir);
     fs::current_path(inv_dir);
 
     // Reset logger
-    const auto log_path = inv_dir / (to_string(getpid()) + ".log");
+    const auto log_path = inv_dir / (log_name + ".log");
     logger.disable_console_logging();
     logger.disable_file_logging();
     logger.enable_file_logging(log_path);
@@ -319,7 +1103,13 @@ void Plankton::verify_conn() {
     dup2(fd, STDERR_FILENO);
     close(fd);
 
-    // Register signal handlers
+    register_ec_sig_handler();
+
+    // Open and load the BPF program (if enabled)
+    DropTrace::get().start();
+}
+
+void Plankton::register_ec_sig_handler() {
     struct sigaction action;
     action.sa_handler = ec_sig_handler;
     sigemptyset(&action.sa_mask);
@@ -330,22 +1120,66 @@ void Plankton::verify_conn() {
     for (size_t i = 0; i < sizeof(sigs) / sizeof(int); ++i) {
         sigaction(sigs[i], &action, nullptr);
     }
+}
 
-    // Open and load the BPF program (if enabled)
-    DropTrace::get().start();
+/**
+ * Sizes the Spin hash table (-w) and the max search depth (-m) with the memory
+ * available to each EC process, instead of the Spin defaults.
+ */
+void Plankton::size_search() {
+    const model_variant *variant = model.get_variant();
+    const double budget = _mem_per_job;
+    const double state_size = variant->state_size;
+    double hash_bits;
+
+    if (variant->search_mode == SEARCH_BITSTATE) {
+        // use half of the budget for the bit array
+        hash_bits = log2(budget / 2 * 8);
+    } else {
+        // one hash table slot per state that can be stored within the budget
+        double stored_size = state_size; // bytes stored per state
+        if (variant->search_mode == SEARCH_COLLAPSE) {
+            stored_size = state_size / 2;
+        } else if (variant->search_mode == SEARCH_HASHCOMPACT) {
+            stored_size = 8;
+        }
+        hash_bits = log2(budget / (2 * sizeof(void *) + stored_size));
+    }
+
+    _spin_hash_bits = clamp(int(hash_bits), 10, 40);
+    // 1/64 of the budget for the search stack
+    _spin_max_depth =
+        clamp(size_t(budget / 64 / (state_size + 32)), size_t(10000),
+              size_t(1000000));
+    logger.info("Spin search: -w" + to_string(_spin_hash_bits) + " -m" +
+                to_string(_spin_max_depth));
+}
 
-    // Run SPIN verifier
-    const string trail_suffix = "-t" + to_string(getpid()) + ".trail";
+void Plankton::run_engine(const string &trail) {
+    if (_engine == "native") {
+        _explorer.explore(model.get_variant(), _mem_per_job, _spin_max_depth,
+                          trail);
+        verify_exit(0);
+    } else {
+        run_spin(trail);
+    }
+}
+
+void Plankton::run_spin(const string &trail) {
+    const model_variant *variant = model.get_variant();
+    const string hash_bits = "-w" + to_string(_spin_hash_bits);
+    const string max_depth = "-m" + to_string(_spin_max_depth);
+    const string trail_suffix = "-t" + trail;
     const char *spin_args[] = {
         // Run-time options: https://spinroot.com/spin/Man/Pan.html#A
         "neo",
         "-E", // suppress invalid end state errors
         "-n", // suppress report for unreached states
+        hash_bits.c_str(),
+        max_depth.c_str(),
         trail_suffix.c_str(),
     };
-    _STATS_START(Stats::Op::CHECK_EC);
-    spin_main(sizeof(spin_args) / sizeof(char *), spin_args);
-    logger.error("verify_exit isn't called by Spin");
+    variant->spin_main(sizeof(spin_args) / sizeof(char *), spin_args);
 }
 
 /**
@@ -428,6 +1262,10 @@ void Plankton::exec_step() {
         verify_exit(0);
     }
 
+    if (_swarm_member > 0) {
+        model.set_choice(swarm_choice(model.get_choice()));
+    }
+
     int process_id = model.get_process_id();
 
     switch (process_id) {
@@ -452,6 +1290,31 @@ void Plankton::exec_step() {
     }
 }
 
+/**
+ * Maps a choice of a swarm member to a permutation of [0, choice_count), so
+ * that the members explore the choices in different orders. The odd members
+ * reverse the order, and the even ones use a pseudo-random affine permutation.
+ * Since the permutation only depends on the member and the current state, the
+ * search remains complete (up to the depth bound) and the trails replayable.
+ */
+int Plankton::swarm_choice(int choice) const {
+    const uint64_t count = model.get_choice_count();
+    if (count < 2) {
+        return choice;
+    } else if (_swarm_member % 2 == 1) {
+        return count - 1 - choice;
+    }
+
+    const int key[] = {int(_swarm_member), model.get_process_id(),
+                       model.get_conn(), int(count)};
+    const uint64_t h = ::hash::hash(key, sizeof(key));
+    uint64_t a = h % count + 1;
+    while (gcd(a, count) != 1) {
+        a = a % count + 1;
+    }
+    return (a * choice + (h >> 32)) % count;
+}
+
 void Plankton::check_to_switch_process() const {
     if (_terminate) {
         verify_exit(0);
@@ -500,15 +1363,72 @@ void Plankton::report() const {
     }
 
     _inv->report();
+    _violated = _violated || model.get_violated();
+    _ec_violated = _ec_violated || model.get_violated();
 }
 
 void Plankton::verify_exit(int status) const {
+    // The helpers of a native explorer only verify a part of an EC
+    if (_explorer.is_helper()) {
+        _explorer.exit_helper(status);
+    }
+
+    // A helper has exceeded the connections of the model variant
+    if (_explorer.conns_exceeded()) {
+        exceed_max_conns();
+    }
+
     // Output per EC process stats
+    const model_variant *variant = model.get_variant();
+    if (_engine == "native") {
+        Stats::get().set_search_counters(_explorer.states_stored(),
+                                         _explorer.hash_conflicts());
+    } else {
+        Stats::get().set_search_counters(*variant->states_stored,
+                                         *variant->hash_conflicts);
+    }
     _STATS_STOP(Stats::Op::CHECK_EC);
     _STATS_LOGRESULTS(Stats::Op::CHECK_EC);
 
+    // Journal the result unless the EC has been cut short. The swarm members
+    // with diversified searches are only conclusive upon violations.
+    const bool violated = _ec_violated || _explorer.violation_found();
+    if (!_terminate && (_swarm_member == 0 || violated)) {
+        const Stats &stats = Stats::get();
+        const Journal::Result res{
+            violated,
+            stats.get_time(Stats::Op::CHECK_EC).count(),
+            stats.get_max_rss(Stats::Op::CHECK_EC),
+            stats.get_states_stored(),
+            stats.get_hash_conflicts(),
+            conns_line(*_inv)};
+        _journal.record(_inv->id(), _ec_idx, res);
+    }
+
     // Remove the BPF program (if enabled)
     DropTrace::get().stop();
 
     exit(status);
 }
+
+/**
+ * Stops verifying the current EC when a connection is translated more times
+ * than the model variant has room for. Unless the variant already has as many
+ * connections as the static model, the EC process exits without journaling the
+ * EC, which the invariant process then verifies again with a larger variant.
+ */
+void Plankton::exceed_max_conns() const {
+    if (model.get_max_conns() >= int(neo_model_variant()->max_conns)) {
+        logger.error("Exceeding the maximum number of connections");
+    }
+
+    logger.warn("Exceeding the " + to_string(model.get_max_conns()) +
+                " connections of the model variant");
+    _explorer.stop_conns_exceeded();
+    if (_explorer.is_helper()) {
+        _explorer.exit_helper(0);
+    }
+
+    DropTrace::get().stop();
+    exit(EXIT_CONNS_EXCEEDED);
+}
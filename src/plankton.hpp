@@ -1,27 +1,75 @@
 #pragma once
 
 #include <csignal>
+#include <cstdint>
 #include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "baseline.hpp"
+#include "explorer.hpp"
+#include "jobcontroller.hpp"
+#include "journal.hpp"
 #include "invariant/invariant.hpp"
 #include "network.hpp"
 #include "process/choose_conn.hpp"
 #include "process/forwarding.hpp"
 #include "process/openflow.hpp"
 
-extern "C" int spin_main(int argc, const char *argv[]);
+// Exit status of an EC process whose connections exceed the model variant
+#define EXIT_CONNS_EXCEEDED 3
+
+/**
+ * Configuration of a verification run, as given by the command-line options
+ * (see main.cpp).
+ */
+struct PlanktonOptions {
+    bool all_ecs = false;                   // Verify all ECs after violation
+    bool resume = false;                    // Resume a killed run
+    bool parallel_invs = false;             // Verify invariants in parallel
+    bool por = false;                       // Partial-order reduction
+    bool symmetry = false;                  // Verify one of symmetric conns
+    bool prioritize = false;                // Verify the riskiest ECs first
+    size_t swarm = 1;                       // Diversified searches per EC
+    size_t sample = 0;                      // Sampled ECs per invariant
+    double sample_fraction = 0;             // Sampled fraction of the ECs
+    size_t shard = 0;                       // Shard to verify (0-based)
+    size_t num_shards = 1;                  // Number of shards
+    size_t max_jobs = 1;                    // Max number of parallel tasks
+    bool adaptive_jobs = false;             // Adapt the number of tasks
+    size_t min_jobs = 1;                    // Min number of parallel tasks
+    size_t max_emu = 0;                     // Max number of emulations (0: all)
+    std::string drop_method = "timeout";    // Drop detection method
+    std::string search_mode = "exhaustive"; // Spin storage mode
+    std::string engine = "spin";            // Exploration engine
+    std::string input_file;                 // Input TOML file
+    std::string output_dir;                 // Output directory
+    std::string cache_dir;                  // Persistent cache directory
+    std::string baseline_dir;               // Output directory of a baseline
+};
 
 class Plankton {
 private:
     // System-wide configuration
     static bool _all_ecs;       // Verify all ECs
     static bool _parallel_invs; // Allow verifying invariants in parallel
+    bool _symmetry;             // Verify one of each symmetric connections
+    bool _prioritize;           // Verify the riskiest ECs first
+    size_t _swarm;              // Number of diversified searches per EC
+    size_t _sample;             // Number of sampled ECs per invariant
+    double _sample_fraction;    // Fraction of sampled ECs per invariant
+    size_t _shard;              // Shard of the ECs to verify (0-based)
+    size_t _num_shards;         // Number of shards
     size_t _max_jobs;           // Max number of parallel tasks
     size_t _max_emu;            // Max number of emulations
     std::string _drop_method;   // Drop detection method
+    uint32_t _search_mode;      // Spin storage mode (SEARCH_*)
+    std::string _engine;        // State-space exploration engine
+    size_t _mem_per_job;        // Available memory per parallel task (bytes)
     std::string _in_file;       // Input TOML file
     std::string _out_dir;       // Output directory
 
@@ -34,19 +82,55 @@ private:
     ForwardingProcess _forwarding;
     OpenflowProcess _openflow;
 
+    // Adaptive concurrency of the EC tasks (main process)
+    JobController _job_ctl;
+    // Results of the finished ECs
+    Journal _journal;
+    // Changes since the baseline run and its results
+    Baseline _baseline;
+
     // Per-invariant system states
     std::shared_ptr<Invariant> _inv; // Currently verified invariant
     static bool _violated;           // A violation has occurred
+    static bool _ec_violated;        // The current EC has been violated
+    size_t _ec_idx;                  // Index of the current EC
+    size_t _swarm_member;            // Swarm member of the current EC task
+    Explorer _explorer;              // Native exploration engine
+    int _spin_hash_bits;             // Spin -w (log2 of hash table size)
+    size_t _spin_max_depth;          // Spin -m (max search depth)
 
+    void wait_tasks();
+    std::vector<size_t> sample_ecs(size_t num_ecs) const;
+    void report_symmetric() const;
+    void report_sample(const std::vector<size_t> &ec_sample,
+                       size_t num_ecs) const;
+    std::vector<size_t> ec_order(const std::vector<size_t> &ec_sample,
+                                 const std::string &inv_desc);
+    void plan_invariant();
     void verify_invariant();
+    bool acquire_job() const;
+    void fork_ec(size_t ec_idx, size_t swarm_member);
     void verify_conn();
+    void init_ec_process(const std::string &log_name);
+    static void register_ec_sig_handler();
+    void size_search();
+    void run_engine(const std::string &trail);
+    void run_spin(const std::string &trail);
+    int swarm_choice(int choice) const;
 
     static bool _terminate;                  // Terminate the entire program
     static std::unordered_set<pid_t> _tasks; // Invariant or EC tasks
+    // EC tasks -> (EC index, swarm member)
+    static std::unordered_map<pid_t, std::pair<size_t, size_t>> _ec_tasks;
+    // ECs to verify again with the static number of connections
+    static std::set<size_t> _conns_exceeded;
     static const int sigs[];
     static void inv_sig_handler(int sig, siginfo_t *siginfo, void *ctx);
     static void ec_sig_handler(int sig);
     static void kill_all_tasks(int sig, pid_t exclude_pid = 0);
+    static void kill_swarm(pid_t pid);
+    static void release_job();
+    static void register_inv_sig_handler();
 
     /***** functions used by the Promela network model *****/
     void check_to_switch_process() const;
@@ -64,18 +148,17 @@ public:
     ~Plankton();
 
     static Plankton &get();
+    // Upper bound of the violation rate from a sample (see report_sample)
+    static double
+    violation_rate_bound(size_t violated, size_t n, size_t num_ecs);
     const decltype(_network) &network() const { return _network; }
+    const decltype(_openflow) &openflow() const { return _openflow; }
     const decltype(_invs) &invariants() const { return _invs; }
 
-    void init(bool all_ecs,
-              bool parallel_invs,
-              size_t max_jobs,
-              size_t max_emu,
-              const std::string &drop_method,
-              const std::string &input_file,
-              const std::string &output_dir);
+    void init(const PlanktonOptions &);
     void reset(bool destruct = false); // Reset as if it was just constructed
     int run();
+    int plan(); // Dry run estimating the verification workload
 
     /***** functions used by the Promela network model *****/
     void initialize();
@@ -83,4 +166,5 @@ public:
     void exec_step();
     void report() const;
     void verify_exit(int) const;
+    [[noreturn]] void exceed_max_conns() const;
 };
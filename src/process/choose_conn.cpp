@@ -1,12 +1,21 @@
 #include "process/choose_conn.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <numeric>
 
 #include "candidates.hpp"
+#include "eqclassmgr.hpp"
+#include "fib.hpp"
+#include "fibmgr.hpp"
 #include "logger.hpp"
+#include "middlebox.hpp"
 #include "model-access.hpp"
+#include "network.hpp"
 #include "process/forwarding.hpp"
 #include "protocols.hpp"
+#include "unique-storage.hpp"
 
 static inline std::vector<std::vector<int>> get_conn_map() {
     std::vector<std::vector<int>> conn_map(3); // executable -> [ conns ]
@@ -28,6 +37,144 @@ static inline std::vector<std::vector<int>> get_conn_map() {
     return conn_map;
 }
 
+// Nodes reachable from `starts` along the FIB (inclusive)
+static std::set<Node *> reachable_nodes(const FIB *fib,
+                                        const std::set<Node *> &starts) {
+    std::set<Node *> visited = starts;
+    std::vector<Node *> stack(starts.begin(), starts.end());
+
+    while (!stack.empty()) {
+        Node *node = stack.back();
+        stack.pop_back();
+
+        for (const FIB_IPNH &next_hop : fib->lookup(node)) {
+            if (visited.insert(next_hop.l3_node()).second) {
+                stack.push_back(next_hop.l3_node());
+            }
+        }
+    }
+
+    return visited;
+}
+
+ChooseConnProcess::ChooseConnProcess() : _por(false), _touched_gen(0) {}
+
+void ChooseConnProcess::init(const Network &network, bool por) {
+    _por = por;
+    _mbs.clear();
+    _mbs.insert(network.middleboxes().begin(), network.middleboxes().end());
+    _touched.clear();
+}
+
+void ChooseConnProcess::reset() {
+    _por = false;
+    _mbs.clear();
+    _touched.clear();
+}
+
+/**
+ * Returns the middleboxes that the connection may touch from now on, i.e.,
+ * the ones reachable from its current location along its FIB, and then along
+ * the FIB of its source address from anywhere on the way (replies). All the
+ * middleboxes are returned if either FIB is unknown.
+ */
+const std::set<Node *> &ChooseConnProcess::touched_mbs(int conn) const {
+    Node *location = model.get_pkt_location_for_conn(conn);
+    FIB *fib = model.get_fib_for_conn(conn);
+    FIB *reply_fib = nullptr;
+    uint32_t src_ip = model.get_src_ip_for_conn(conn);
+
+    if (src_ip != 0) {
+        EqClass *src_ec = EqClassMgr::get().find_ec(src_ip);
+        reply_fib = FIBMgr::get().get_fib(src_ec,
+                                          model.get_openflow_update_state());
+    }
+
+    if (!location || !fib || !reply_fib) {
+        return _mbs;
+    }
+
+    // The FIBs of a cleared storage may be reallocated at the same addresses
+    if (_touched_gen != storage.get_generation()) {
+        _touched.clear();
+        _touched_gen = storage.get_generation();
+    }
+
+    auto res = _touched.try_emplace({fib, reply_fib, location});
+    if (res.second) {
+        std::set<Node *> nodes = reachable_nodes(fib, {location});
+        nodes = reachable_nodes(reply_fib, nodes);
+        std::set_intersection(nodes.begin(), nodes.end(), _mbs.begin(),
+                              _mbs.end(),
+                              std::inserter(res.first->second,
+                                            res.first->second.begin()));
+    }
+    return res.first->second;
+}
+
+/**
+ * Groups the live connections (pending: about to enter a middlebox, waiting:
+ * missing packets) by the middleboxes they may touch, and returns the pending
+ * connections of the group that has the fewest of them.
+ */
+std::vector<int>
+ChooseConnProcess::persistent_set(const std::vector<int> &pending,
+                                  const std::vector<int> &waiting) const {
+    std::vector<int> conns(pending);
+    conns.insert(conns.end(), waiting.begin(), waiting.end());
+    std::vector<const std::set<Node *> *> touched;
+    for (int conn : conns) {
+        touched.push_back(&touched_mbs(conn));
+    }
+
+    // union-find of the dependent connections
+    std::vector<size_t> group(conns.size());
+    std::iota(group.begin(), group.end(), 0);
+    auto find = [&](size_t i) {
+        while (group[i] != i) {
+            i = group[i] = group[group[i]];
+        }
+        return i;
+    };
+
+    for (size_t i = 0; i < conns.size(); ++i) {
+        for (size_t j = i + 1; j < conns.size(); ++j) {
+            const auto &a = *touched[i], &b = *touched[j];
+            bool dependent = std::any_of(
+                a.begin(), a.end(), [&](Node *mb) { return b.count(mb) > 0; });
+            if (dependent) {
+                group[find(j)] = find(i);
+            }
+        }
+    }
+
+    std::map<size_t, std::vector<int>> pending_by_group;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        pending_by_group[find(i)].push_back(pending[i]);
+    }
+
+    const std::vector<int> *smallest = nullptr;
+    for (const auto &[_, group_conns] : pending_by_group) {
+        if (!smallest || group_conns.size() < smallest->size()) {
+            smallest = &group_conns;
+        }
+    }
+    return *smallest;
+}
+
+/**
+ * Returns the connections to choose from when none is executable without
+ * entering a middlebox (conn_map[2]).
+ */
+std::vector<int>
+ChooseConnProcess::choices(const std::vector<std::vector<int>> &conn_map) const {
+    if (!_por || conn_map[1].size() <= 1) {
+        return conn_map[1];
+    }
+
+    return persistent_set(conn_map[1], conn_map[0]);
+}
+
 void ChooseConnProcess::update_choice_count() const {
     std::vector<std::vector<int>> conn_map = get_conn_map();
     /**
@@ -39,7 +186,7 @@ void ChooseConnProcess::update_choice_count() const {
     if (!conn_map[2].empty()) {
         model.set_choice_count(1);
     } else if (!conn_map[1].empty()) {
-        model.set_choice_count(conn_map[1].size());
+        model.set_choice_count(choices(conn_map).size());
     } else if (!conn_map[0].empty()) {
         model.set_choice_count(1);
     } else {
@@ -63,7 +210,7 @@ void ChooseConnProcess::exec_step() {
         model.set_conn(conn_map[2][0]);
         model.print_conn_states();
     } else if (!conn_map[1].empty()) {
-        model.set_conn(conn_map[1][choice]);
+        model.set_conn(choices(conn_map)[choice]);
         model.set_executable(2);
         model.print_conn_states();
     } else if (!conn_map[0].empty()) {
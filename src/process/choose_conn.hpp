@@ -1,12 +1,53 @@
 #pragma once
 
+#include <cstddef>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
 #include "process/process.hpp"
 
+class FIB;
+class Network;
+class Node;
+
 /**
  * Choose the next connection non-deterministically
+ *
+ * With partial-order reduction enabled, only the connections of one group of
+ * interdependent connections are chosen from, instead of all the connections
+ * about to enter a middlebox. Two connections are dependent if the sets of
+ * middleboxes they may touch intersect, where the middleboxes a connection may
+ * touch are the ones reachable from its current location along the FIBs of its
+ * destination (requests) and source (replies). Since connections of different
+ * groups never inject packets into the same middlebox, all the orders between
+ * the groups lead to the same states, and exploring one of them suffices (a
+ * persistent set). This assumes that middleboxes do not redirect packets off
+ * the FIB paths of the connection, and that openflow updates are absent. As
+ * rewriting middleboxes (e.g., NATs and load balancers) may break that, the
+ * reduction is opt-in (`--enable-por`).
  */
 class ChooseConnProcess : public Process {
+private:
+    bool _por;             // partial-order reduction
+    std::set<Node *> _mbs; // all middleboxes
+    // (fib, reply fib, location) -> middleboxes that may be touched, which is
+    // only valid for the UniqueStorage generation the FIBs were stored in
+    mutable std::map<std::tuple<FIB *, FIB *, Node *>, std::set<Node *>>
+        _touched;
+    mutable size_t _touched_gen;
+
+    const std::set<Node *> &touched_mbs(int conn) const;
+    std::vector<int> persistent_set(const std::vector<int> &pending,
+                                    const std::vector<int> &waiting) const;
+    std::vector<int> choices(const std::vector<std::vector<int>> &conn_map) const;
+
 public:
+    ChooseConnProcess();
+
+    void init(const Network &, bool por);
+    void reset() override;
     void update_choice_count() const;
     void exec_step() override;
 };
@@ -1,5 +1,6 @@
 #include "process/forwarding.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <optional>
 #include <utility>
@@ -17,6 +18,7 @@
 #include "network.hpp"
 #include "payload.hpp"
 #include "payloadmgr.hpp"
+#include "plankton.hpp"
 #include "protocols.hpp"
 #include "stats.hpp"
 #include "unique-storage.hpp"
@@ -104,7 +106,7 @@ void ForwardingProcess::collect_next_hops() {
         return;
     } // else: current_node is a Node; look up next hops from FIB
 
-    set<FIB_IPNH> next_hops = model.get_fib()->lookup(current_node);
+    const auto next_hops = model.get_fib()->lookup(current_node);
     if (next_hops.empty()) {
         logger.info("Connection " + to_string(model.get_conn()) +
                     " dropped by " + current_node->to_string());
@@ -119,7 +121,8 @@ void ForwardingProcess::collect_next_hops() {
     optional<FIB_IPNH> choice = choices->get_choice(ec, current_node);
 
     // in case of multipath, use the past choice if it's been made
-    if (next_hops.size() > 1 && choice && next_hops.count(*choice) > 0) {
+    if (next_hops.size() > 1 && choice &&
+        binary_search(next_hops.begin(), next_hops.end(), *choice)) {
         candidates.add(*choice);
     } else {
         for (const FIB_IPNH &next_hop : next_hops) {
@@ -330,23 +333,21 @@ void ForwardingProcess::inject_packet(Middlebox *mb) {
     PacketHistory *pkt_hist = model.get_pkt_hist();
     NodePacketHistory *current_nph = pkt_hist->get_node_pkt_hist(mb);
 
-    // Rewind the middlebox state if needed
-    mb->rewind(current_nph);
-
     // Construct new packet
-    Packet *new_pkt = storage.store_packet(new Packet(model));
+    Packet *new_pkt = storage.store_packet(Packet(model));
 
     // Update node_pkt_hist with this new packet
-    NodePacketHistory *new_nph = new NodePacketHistory(new_pkt, current_nph);
-    new_nph = storage.store_node_pkt_hist(new_nph);
-    mb->set_node_pkt_hist(new_nph);
+    NodePacketHistory *new_nph =
+        storage.store_node_pkt_hist(NodePacketHistory(new_pkt, current_nph));
 
     // Update pkt_hist with this new node_pkt_hist
     PacketHistory new_pkt_hist(*pkt_hist);
     new_pkt_hist.set_node_pkt_hist(mb, new_nph);
     model.set_pkt_hist(std::move(new_pkt_hist));
 
-    // Check if we have previous injection results cached.
+    // Check if we have previous injection results cached, either by this
+    // process or by any other process sharing the cache. The emulation is
+    // left untouched on a cache hit, as the packet is never actually sent.
     InjectionResults *cached_results = injection_cache.get(mb, new_nph);
 
     if (cached_results) {
@@ -357,6 +358,10 @@ void ForwardingProcess::inject_packet(Middlebox *mb) {
         model.set_injection_results(cached_results);
         model.set_fwd_mode(fwd_mode::CHOOSE_INJ_RES);
     } else {
+        // Rewind the middlebox state if needed
+        mb->rewind(current_nph);
+        mb->set_node_pkt_hist(new_nph);
+
         // Inject packet
         logger.info("Injecting packet: " + new_pkt->to_string());
         InjectionResults results = mb->send_pkt(*new_pkt);
@@ -398,6 +403,9 @@ void ForwardingProcess::update_model_from_injection_result(
         }
 
         Net::get().identify_conn(recv_pkt);
+        if (recv_pkt.conn() >= model.get_max_conns()) {
+            Plankton::get().exceed_max_conns();
+        }
         Net::get().process_proto_state(recv_pkt);
         if (recv_pkt.get_proto_state() == PS_INVALID) {
             continue;
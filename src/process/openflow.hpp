@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "lib/idmap.hpp"
 #include "process/process.hpp"
 class Invariant;
 class Node;
@@ -14,7 +15,7 @@ class FIB_IPNH;
 /**
  * The state of how many updates have been installed.
  */
-class OpenflowUpdateState {
+class OpenflowUpdateState : public DenseID {
 private:
     // index: node order in Openflow::updates
     // value: number of installed updates of that node
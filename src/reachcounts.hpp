@@ -3,9 +3,11 @@
 #include <string>
 #include <unordered_map>
 
+#include "lib/idmap.hpp"
+
 class Node;
 
-class ReachCounts {
+class ReachCounts : public DenseID {
 private:
     std::unordered_map<Node *, int> counts;
 
@@ -26,6 +26,7 @@ RoutingTable::iterator RoutingTable::insert(const Route &route) {
             }
         }
     }
+    lpm.insert(route.get_network());
     return tbl.insert(route);
 }
 
@@ -44,29 +45,46 @@ RoutingTable::iterator RoutingTable::insert(Route &&route) {
             }
         }
     }
+    lpm.insert(route.get_network());
     return tbl.insert(std::move(route));
 }
 
 RoutingTable::iterator RoutingTable::update(const Route &route) {
     tbl.erase(route);
+    lpm.insert(route.get_network());
     return tbl.insert(route);
 }
 
 RoutingTable::iterator RoutingTable::update(Route &&route) {
     tbl.erase(route);
+    lpm.insert(route.get_network());
     return tbl.insert(std::move(route));
 }
 
 RoutingTable::size_type RoutingTable::erase(const Route &route) {
-    return tbl.erase(route);
+    size_type n = tbl.erase(route);
+    sync_lpm(route.get_network());
+    return n;
 }
 
 RoutingTable::iterator RoutingTable::erase(const_iterator it) {
-    return tbl.erase(it);
+    IPNetwork<IPv4Address> net = it->get_network();
+    iterator next = tbl.erase(it);
+    sync_lpm(net);
+    return next;
 }
 
 void RoutingTable::clear() {
     tbl.clear();
+    lpm.clear();
+}
+
+void RoutingTable::sync_lpm(const IPNetwork<IPv4Address> &net) {
+    if (tbl.count(Route(net)) > 0) {
+        lpm.insert(net);
+    } else {
+        lpm.erase(net);
+    }
 }
 
 std::pair<RoutingTable::iterator, RoutingTable::iterator>
@@ -81,20 +99,18 @@ RoutingTable::lookup(const IPNetwork<IPv4Address> &dst_net) const {
 
 std::pair<RoutingTable::iterator, RoutingTable::iterator>
 RoutingTable::lookup(const IPv4Address &dst) {
-    for (const Route &route : tbl) {
-        if (route.get_network().contains(dst)) { // longest prefix match
-            return tbl.equal_range(route);
-        }
+    auto net = lpm.lookup(dst); // longest prefix match
+    if (net) {
+        return tbl.equal_range(Route(*net));
     }
     return std::make_pair(tbl.end(), tbl.end());
 }
 
 std::pair<RoutingTable::const_iterator, RoutingTable::const_iterator>
 RoutingTable::lookup(const IPv4Address &dst) const {
-    for (const Route &route : tbl) {
-        if (route.get_network().contains(dst)) { // longest prefix match
-            return tbl.equal_range(route);
-        }
+    auto net = lpm.lookup(dst); // longest prefix match
+    if (net) {
+        return tbl.equal_range(Route(*net));
     }
     return std::make_pair(tbl.cend(), tbl.cend());
 }
@@ -4,11 +4,15 @@
 #include <string>
 #include <utility>
 
+#include "lib/lpm-trie.hpp"
 #include "route.hpp"
 
 class RoutingTable {
 private:
     std::multiset<Route> tbl;
+    LPMTrie lpm; // prefixes of tbl for longest prefix matching
+
+    void sync_lpm(const IPNetwork<IPv4Address> &);
 
 public:
     typedef std::multiset<Route>::size_type size_type;
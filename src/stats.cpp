@@ -69,12 +69,31 @@ const vector<chrono::microseconds> &Stats::get_pkt_latencies() const {
     return _latencies.at(Op::PKT_LAT);
 }
 
+microseconds Stats::get_time(Op op) const {
+    return _time.at(op);
+}
+
+long Stats::get_max_rss(Op op) const {
+    return _max_rss.at(op);
+}
+
+long long Stats::get_states_stored() const {
+    return _states_stored;
+}
+
+long long Stats::get_hash_conflicts() const {
+    return _hash_conflicts;
+}
+
 void Stats::start(Op op) {
     if (_start_ts.count(op) > 0) {
         logger.error("Multiple starting time point for op: " + _op_str.at(op));
     }
 
     _start_ts[op] = clock::now();
+    if (op == Op::CHECK_INVARIANT) {
+        _first_violation = microseconds(-1);
+    }
 }
 
 void Stats::stop(Op op) {
@@ -119,6 +138,23 @@ void Stats::set_rewind_injection_count(int n) {
     }
 }
 
+void Stats::set_search_counters(double states_stored, double hash_conflicts) {
+    _states_stored = states_stored;
+    _hash_conflicts = hash_conflicts;
+}
+
+/**
+ * Records the time since the start of the invariant check, if it's the first
+ * violation of the invariant.
+ */
+void Stats::mark_violation() {
+    auto it = _start_ts.find(Op::CHECK_INVARIANT);
+    if (it != _start_ts.end() && _first_violation.count() < 0) {
+        _first_violation =
+            duration_cast<microseconds>(clock::now() - it->second);
+    }
+}
+
 void Stats::reset() {
     _start_ts.clear();
 
@@ -133,6 +169,9 @@ void Stats::reset() {
     }
 
     _rewind_injection_count.clear();
+    _states_stored = -1;
+    _hash_conflicts = -1;
+    _first_violation = microseconds(-1);
 }
 
 void Stats::log_results(Op op) const {
@@ -152,8 +191,15 @@ void Stats::log_results(Op op) const {
             logger.error("Failed to open " + filename);
         }
 
-        ofs << "Time (usec), Peak memory (KiB), Current memory (KiB)" << endl
-            << time << ", " << max_rss << ", " << cur_rss << endl;
+        ofs << "Time (usec), Peak memory (KiB), Current memory (KiB), "
+            << "Time to first violation (usec)" << endl
+            << time << ", " << max_rss << ", " << cur_rss << ", "
+            << _first_violation.count() << endl;
+
+        if (_first_violation.count() >= 0) {
+            logger.info("Time to first violation: " +
+                        to_string(_first_violation.count()) + " usec");
+        }
     } else if (op == Op::CHECK_EC) {
         const string filename = to_string(getpid()) + ".stats.csv";
         ofstream ofs(filename);
@@ -161,8 +207,10 @@ void Stats::log_results(Op op) const {
             logger.error("Failed to open " + filename);
         }
 
-        ofs << "Time (usec), Peak memory (KiB), Current memory (KiB)" << endl
-            << time << ", " << max_rss << ", " << cur_rss << endl;
+        ofs << "Time (usec), Peak memory (KiB), Current memory (KiB), "
+            << "States stored, Hash conflicts" << endl
+            << time << ", " << max_rss << ", " << cur_rss << ", "
+            << _states_stored << ", " << _hash_conflicts << endl;
         ofs << "Overall concretization (usec), " << "Emulation startup (usec), "
             << "Rewind (usec), " << "Emulation reset (usec), "
             << "Replay packets (usec), " << "Rewind injection count, "
@@ -94,6 +94,11 @@ private:
      * needed.
      */
     std::vector<int> _rewind_injection_count;
+    // Spin counters of the connection EC (-1 if unknown)
+    long long _states_stored = -1;
+    long long _hash_conflicts = -1;
+    // Time to the first violation of the invariant (-1 if not violated)
+    std::chrono::microseconds _first_violation{-1};
 
     Stats() = default;
 
@@ -109,11 +114,17 @@ public:
 
     static Stats &get();
     const std::vector<std::chrono::microseconds> &get_pkt_latencies() const;
+    std::chrono::microseconds get_time(Op) const;
+    long get_max_rss(Op) const;
+    long long get_states_stored() const;
+    long long get_hash_conflicts() const;
 
     void start(Op);
     void stop(Op);
     void set_zero_latency(Op);
     void set_rewind_injection_count(int);
+    void set_search_counters(double states_stored, double hash_conflicts);
+    void mark_violation();
     void reset();
     void log_results(Op) const;
 };
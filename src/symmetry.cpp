@@ -0,0 +1,180 @@
+#include "symmetry.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "connmatrix.hpp"
+#include "eqclass.hpp"
+#include "eqclassmgr.hpp"
+#include "fib.hpp"
+#include "fibmgr.hpp"
+#include "interface.hpp"
+#include "logger.hpp"
+#include "middlebox.hpp"
+#include "node.hpp"
+#include "protocols.hpp"
+
+using namespace std;
+
+Symmetry::Symmetry(const unordered_set<Node *> &distinguished_nodes) :
+    _distinguished(distinguished_nodes) {}
+
+static string intf_name(const Interface *intf) {
+    return intf ? intf->get_name() : "";
+}
+
+/**
+ * Returns which of the configured prefixes and addresses of the middlebox
+ * contain the source IP and the destination address, respectively.
+ */
+static string mb_matches(const Middlebox *mb,
+                         const IPv4Address &src_ip,
+                         const IPv4Address &dst_ip) {
+    string bits;
+    for (const auto &prefix : mb->ec_ip_prefixes()) {
+        bits += char('0' + prefix.contains(src_ip) * 2 + prefix.contains(dst_ip));
+    }
+    for (const auto &addr : mb->ec_ip_addrs()) {
+        bits += char('0' + (addr == src_ip) * 2 + (addr == dst_ip));
+    }
+    return bits;
+}
+
+/**
+ * Returns the canonical encoding of the forwarding slice, or an empty string if
+ * the slice cannot be determined, in which case the connection is not grouped
+ * with any other.
+ */
+string Symmetry::slice_signature(Node *src_node, EqClass *dst_ip_ec) const {
+    FIBMgr &fib_mgr = FIBMgr::get();
+    const IPv4Address dst_ip = dst_ip_ec->representative_addr();
+
+    // The source IP is set by the egress interface of the first hop (see
+    // ForwardingProcess::first_forward)
+    set<IPv4Address> src_ips;
+    for (const auto &next_hops : fib_mgr.get_all_ipnhs(dst_ip_ec, src_node)) {
+        for (const FIB_IPNH &next_hop : next_hops) {
+            if (next_hop.l2_intf()) {
+                src_ips.insert(next_hop.l2_node()
+                                   ->get_peer(next_hop.l2_intf()->get_name())
+                                   .second->addr());
+            } else if (!src_node->loopback_intf()->is_l2()) {
+                src_ips.insert(src_node->loopback_intf()->addr());
+            }
+        }
+    }
+    if (src_ips.size() != 1) {
+        return "";
+    }
+    const IPv4Address src_ip = *src_ips.begin();
+    EqClass *src_ip_ec = EqClassMgr::get().find_ec(src_ip);
+
+    unordered_map<Node *, size_t> index; // BFS discovery order
+    deque<Node *> queue;
+    auto label = [&](Node *node) {
+        auto res = index.try_emplace(node, index.size());
+        if (res.second) {
+            queue.push_back(node);
+        }
+
+        if (node->is_emulated()) {
+            return node->get_name() + '(' +
+                   mb_matches(static_cast<Middlebox *>(node), src_ip, dst_ip) +
+                   ')';
+        } else if (_distinguished.count(node) > 0) {
+            return node->get_name();
+        }
+        return '#' + to_string(res.first->second);
+    };
+    auto hop = [&](Node *node, const Interface *intf) {
+        const string node_label = label(node);
+        return node_label[0] == '#' ? node_label
+                                    : node_label + '/' + intf_name(intf);
+    };
+
+    string sig;
+    label(src_node);
+    while (!queue.empty()) {
+        Node *node = queue.front();
+        queue.pop_front();
+        sig += label(node) + ':';
+
+        for (EqClass *ec : {dst_ip_ec, src_ip_ec}) {
+            vector<set<FIB_IPNH>> all_ipnhs = fib_mgr.get_all_ipnhs(ec, node);
+            if (all_ipnhs.empty()) {
+                return ""; // EC not precomputed
+            }
+
+            for (const auto &next_hops : all_ipnhs) {
+                vector<const FIB_IPNH *> sorted;
+                for (const FIB_IPNH &next_hop : next_hops) {
+                    sorted.push_back(&next_hop);
+                }
+                stable_sort(sorted.begin(), sorted.end(),
+                            [](const FIB_IPNH *a, const FIB_IPNH *b) {
+                                return make_pair(intf_name(a->l3_intf()),
+                                                 intf_name(a->l2_intf())) <
+                                       make_pair(intf_name(b->l3_intf()),
+                                                 intf_name(b->l2_intf()));
+                            });
+
+                sig += '[';
+                for (const FIB_IPNH *next_hop : sorted) {
+                    sig += hop(next_hop->l3_node(), next_hop->l3_intf()) + ',' +
+                           hop(next_hop->l2_node(), next_hop->l2_intf()) + ' ';
+                }
+                sig += ']';
+            }
+            sig += ';';
+        }
+        sig += '\n';
+    }
+
+    return sig;
+}
+
+vector<vector<Connection>>
+Symmetry::reduce(const set<Connection> &conns) const {
+    map<pair<Node *, EqClass *>, string> slices;
+    map<string, vector<const Connection *>> groups;
+
+    for (const Connection &conn : conns) {
+        auto res = slices.try_emplace({conn.get_src_node(), conn.get_dst_ip_ec()});
+        if (res.second) {
+            res.first->second =
+                slice_signature(conn.get_src_node(), conn.get_dst_ip_ec());
+        }
+
+        const string &slice = res.first->second;
+        string sig = proto_str(conn.get_protocol()) + ' ' +
+                     to_string(conn.get_src_port()) + ' ' +
+                     to_string(conn.get_dst_port()) + '\n' +
+                     (slice.empty() ? conn.to_string() : slice);
+        groups[sig].push_back(&conn);
+    }
+
+    vector<vector<Connection>> reduced;
+    for (auto &[_, group] : groups) {
+        // The same representative in every process, regardless of the heap
+        sort(group.begin(), group.end(),
+             [](const Connection *a, const Connection *b) {
+                 return ConnectionSet::stable_less(*a, *b);
+             });
+        vector<Connection> &members = reduced.emplace_back();
+        for (const Connection *conn : group) {
+            members.push_back(*conn);
+        }
+        if (group.size() > 1) {
+            logger.info(members[0].to_string() + " represents " +
+                        to_string(group.size()) + " symmetric connections");
+        }
+    }
+
+    logger.info("Symmetry reduction: " + to_string(conns.size()) + " -> " +
+                to_string(reduced.size()) + " connections");
+    return reduced;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "conn.hpp"
+
+class EqClass;
+class Node;
+
+/**
+ * Symmetry groups the connections of an invariant whose forwarding slices are
+ * isomorphic, so that only one representative of each group is verified
+ * (`--symmetry`).
+ *
+ * The forwarding slice of a connection consists of the nodes reachable from its
+ * source node along the FIBs of its destination EC (requests) and of its source
+ * IP (replies), under any number of installed openflow updates. The slice is
+ * encoded canonically by relabeling the nodes in the BFS discovery order, with
+ * the next hops ordered by interface names. The relabeled nodes only forward by
+ * their FIBs, so their interface names are left out of the encoding. The nodes
+ * referred to by the invariant (e.g., target nodes) and the middleboxes keep
+ * their names and interface names. Since
+ * the middleboxes see the actual addresses, each of them is also labeled with
+ * which of its configured prefixes and addresses match the source IP and the
+ * destination EC. This assumes that the middleboxes only differentiate the
+ * addresses by those prefixes and addresses, so the reduction is opt-in.
+ */
+class Symmetry {
+private:
+    std::unordered_set<Node *> _distinguished;
+
+    std::string slice_signature(Node *src_node, EqClass *dst_ip_ec) const;
+
+public:
+    Symmetry(const std::unordered_set<Node *> &distinguished_nodes);
+
+    // Returns the groups of symmetric connections, each led by the connection
+    // representing the group
+    std::vector<std::vector<Connection>>
+    reduce(const std::set<Connection> &) const;
+};
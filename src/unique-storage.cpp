@@ -1,4 +1,7 @@
 #include "unique-storage.hpp"
+
+#include <type_traits>
+
 #include "invariant/loop.hpp"
 #include "pkt-hist.hpp"
 
@@ -11,162 +14,92 @@ UniqueStorage &UniqueStorage::get() {
     return instance;
 }
 
+/**
+ * The stored objects are destroyed with their arenas, rather than deleted one
+ * by one.
+ */
 void UniqueStorage::reset() {
-    for (Candidates *candidates : this->candidates_store) {
-        delete candidates;
-    }
     this->candidates_store.clear();
-
-    for (FIB *fib : this->fib_store) {
-        delete fib;
-    }
     this->fib_store.clear();
-
-    for (Choices *path_choices : this->choices_store) {
-        delete path_choices;
-    }
     this->choices_store.clear();
-
-    for (Packet *pkt : this->pkt_store) {
-        delete pkt;
-    }
     this->pkt_store.clear();
-
-    for (NodePacketHistory *nph : this->node_pkt_hist_store) {
-        delete nph;
-    }
     this->node_pkt_hist_store.clear();
-
-    for (PacketHistory *pkt_hist : this->pkt_hist_store) {
-        delete pkt_hist;
-    }
     this->pkt_hist_store.clear();
-
-    for (OpenflowUpdateState *update_state :
-         this->openflow_update_state_store) {
-        delete update_state;
-    }
     this->openflow_update_state_store.clear();
-
-    for (ReachCounts *reach_counts : this->reach_counts_store) {
-        delete reach_counts;
-    }
     this->reach_counts_store.clear();
-
-    for (InjectionResult *result : this->injection_result_store) {
-        delete result;
-    }
     this->injection_result_store.clear();
-
-    for (InjectionResults *results : this->injection_results_store) {
-        delete results;
-    }
     this->injection_results_store.clear();
-
-    for (VisitedHops *hops : this->visited_hops_store) {
-        delete hops;
-    }
     this->visited_hops_store.clear();
+
+    std::apply([](auto &...arenas) { (arenas.reset(), ...); }, this->arenas);
+    std::apply([](auto &...id_maps) { (id_maps.clear(), ...); }, this->ids);
+    ++this->generation;
 }
 
-Candidates *UniqueStorage::store_candidates(Candidates *candidates) {
-    auto res = storage.candidates_store.insert(candidates);
-    if (!res.second && candidates != *(res.first)) {
-        delete candidates;
-        candidates = *(res.first);
-    }
-    return candidates;
+/**
+ * Returns the stored object equal to the candidate if there is one. Otherwise,
+ * the candidate is moved into the arena and stored, and assigned its ID if it
+ * is referred to by the state vector.
+ */
+template <class T, class Store>
+T *UniqueStorage::intern(T &&candidate, Store &store) {
+    const size_t hash = store.hash(&candidate);
+    T *obj = store.find(&candidate, hash);
+    if (obj) {
+        return obj;
+    }
+
+    obj = std::get<Arena<T>>(this->arenas).create(std::move(candidate));
+    store.insert(obj, hash);
+    if constexpr (std::is_base_of_v<DenseID, T>) {
+        std::get<IDMap<T>>(this->ids).assign(obj);
+    }
+    return obj;
 }
 
-FIB *UniqueStorage::store_fib(FIB *fib) {
-    auto res = storage.fib_store.insert(fib);
-    if (!res.second && fib != *(res.first)) {
-        delete fib;
-        fib = *(res.first);
-    }
-    return fib;
+Candidates *UniqueStorage::store_candidates(Candidates &&candidates) {
+    return intern(std::move(candidates), this->candidates_store);
 }
 
-Choices *UniqueStorage::store_choices(Choices *choices) {
-    auto res = storage.choices_store.insert(choices);
-    if (!res.second && choices != *(res.first)) {
-        delete choices;
-        choices = *(res.first);
-    }
-    return choices;
+FIB *UniqueStorage::store_fib(FIB &&fib) {
+    return intern(std::move(fib), this->fib_store);
 }
 
-Packet *UniqueStorage::store_packet(Packet *packet) {
-    auto res = storage.pkt_store.insert(packet);
-    if (!res.second && packet != *(res.first)) {
-        delete packet;
-        packet = *(res.first);
-    }
-    return packet;
+Choices *UniqueStorage::store_choices(Choices &&choices) {
+    return intern(std::move(choices), this->choices_store);
 }
 
-NodePacketHistory *UniqueStorage::store_node_pkt_hist(NodePacketHistory *nph) {
-    auto res = storage.node_pkt_hist_store.insert(nph);
-    if (!res.second && nph != *(res.first)) {
-        delete nph;
-        nph = *(res.first);
-    }
-    return nph;
+Packet *UniqueStorage::store_packet(Packet &&packet) {
+    return intern(std::move(packet), this->pkt_store);
 }
 
-PacketHistory *UniqueStorage::store_pkt_hist(PacketHistory *pkt_hist) {
-    auto res = storage.pkt_hist_store.insert(pkt_hist);
-    if (!res.second && pkt_hist != *(res.first)) {
-        delete pkt_hist;
-        pkt_hist = *(res.first);
-    }
-    return pkt_hist;
+NodePacketHistory *UniqueStorage::store_node_pkt_hist(NodePacketHistory &&nph) {
+    return intern(std::move(nph), this->node_pkt_hist_store);
+}
+
+PacketHistory *UniqueStorage::store_pkt_hist(PacketHistory &&pkt_hist) {
+    return intern(std::move(pkt_hist), this->pkt_hist_store);
 }
 
 OpenflowUpdateState *
-UniqueStorage::store_of_update_state(OpenflowUpdateState *update_state) {
-    auto res = storage.openflow_update_state_store.insert(update_state);
-    if (!res.second && update_state != *(res.first)) {
-        delete update_state;
-        update_state = *(res.first);
-    }
-    return update_state;
+UniqueStorage::store_of_update_state(OpenflowUpdateState &&update_state) {
+    return intern(std::move(update_state), this->openflow_update_state_store);
 }
 
-ReachCounts *UniqueStorage::store_reach_counts(ReachCounts *reach_counts) {
-    auto res = storage.reach_counts_store.insert(reach_counts);
-    if (!res.second && reach_counts != *(res.first)) {
-        delete reach_counts;
-        reach_counts = *(res.first);
-    }
-    return reach_counts;
+ReachCounts *UniqueStorage::store_reach_counts(ReachCounts &&reach_counts) {
+    return intern(std::move(reach_counts), this->reach_counts_store);
 }
 
 InjectionResult *
-UniqueStorage::store_injection_result(InjectionResult *result) {
-    auto res = storage.injection_result_store.insert(result);
-    if (!res.second && result != *(res.first)) {
-        delete result;
-        result = *(res.first);
-    }
-    return result;
+UniqueStorage::store_injection_result(InjectionResult &&result) {
+    return intern(std::move(result), this->injection_result_store);
 }
 
 InjectionResults *
-UniqueStorage::store_injection_results(InjectionResults *results) {
-    auto res = storage.injection_results_store.insert(results);
-    if (!res.second && results != *(res.first)) {
-        delete results;
-        results = *(res.first);
-    }
-    return results;
+UniqueStorage::store_injection_results(InjectionResults &&results) {
+    return intern(std::move(results), this->injection_results_store);
 }
 
-VisitedHops *UniqueStorage::store_visited_hops(VisitedHops *hops) {
-    auto res = storage.visited_hops_store.insert(hops);
-    if (!res.second && hops != *(res.first)) {
-        delete hops;
-        hops = *(res.first);
-    }
-    return hops;
+VisitedHops *UniqueStorage::store_visited_hops(VisitedHops &&hops) {
+    return intern(std::move(hops), this->visited_hops_store);
 }
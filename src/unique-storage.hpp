@@ -1,50 +1,88 @@
 #pragma once
 
-#include <unordered_set>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
 
 #include "candidates.hpp"
 #include "choices.hpp"
 #include "fib.hpp"
 #include "injection-result.hpp"
 #include "invariant/loop.hpp"
+#include "lib/arena.hpp"
+#include "lib/idmap.hpp"
+#include "lib/intern-table.hpp"
 #include "packet.hpp"
 #include "pkt-hist.hpp"
 #include "process/openflow.hpp"
 #include "reachcounts.hpp"
 
+/**
+ * UniqueStorage interns the objects referred to by the model states, so that
+ * equal objects are stored once and compared by pointers. A candidate object
+ * is built by the caller (usually on the stack) and only moved into the arena
+ * of its type if no equal object is stored yet.
+ */
 class UniqueStorage {
 private:
     UniqueStorage() = default;
+    friend class Explorer;
     friend class Plankton;
     void reset();
 
+    template <class T, class Store>
+    T *intern(T &&, Store &);
+
     // Variables of unique storage for preventing duplicates
-    std::unordered_set<Candidates *, CandHash, CandEq> candidates_store;
-    std::unordered_set<FIB *, FIBHash, FIBEq> fib_store;
-    std::unordered_set<Choices *, ChoicesHash, ChoicesEq> choices_store;
+    InternTable<Candidates, CandHash, CandEq> candidates_store;
+    InternTable<FIB, FIBHash, FIBEq> fib_store;
+    InternTable<Choices, ChoicesHash, ChoicesEq> choices_store;
     // All sent packets
-    std::unordered_set<Packet *, PacketPtrHash, PacketPtrEq> pkt_store;
-    std::unordered_set<NodePacketHistory *,
-                       NodePacketHistoryHash,
-                       NodePacketHistoryEq>
+    InternTable<Packet, PacketPtrHash, PacketPtrEq> pkt_store;
+    InternTable<NodePacketHistory, NodePacketHistoryHash, NodePacketHistoryEq>
         node_pkt_hist_store;
-    std::unordered_set<PacketHistory *, PacketHistoryHash, PacketHistoryEq>
+    InternTable<PacketHistory, PacketHistoryHash, PacketHistoryEq>
         pkt_hist_store;
-    std::
-        unordered_set<OpenflowUpdateState *, OFUpdateStateHash, OFUpdateStateEq>
-            openflow_update_state_store;
-    std::unordered_set<ReachCounts *, ReachCountsHash, ReachCountsEq>
+    InternTable<OpenflowUpdateState, OFUpdateStateHash, OFUpdateStateEq>
+        openflow_update_state_store;
+    InternTable<ReachCounts, ReachCountsHash, ReachCountsEq>
         reach_counts_store;
-    std::
-        unordered_set<InjectionResult *, InjectionResultHash, InjectionResultEq>
-            injection_result_store;
-    std::unordered_set<InjectionResults *,
-                       InjectionResultsHash,
-                       InjectionResultsEq>
+    InternTable<InjectionResult, InjectionResultHash, InjectionResultEq>
+        injection_result_store;
+    InternTable<InjectionResults, InjectionResultsHash, InjectionResultsEq>
         injection_results_store;
-    std::unordered_set<VisitedHops *, VisitedHopsHash, VisitedHopsEq>
+    InternTable<VisitedHops, VisitedHopsHash, VisitedHopsEq>
         visited_hops_store;
 
+    // Memory of the stored objects, released all at once by reset()
+    std::tuple<Arena<Candidates>,
+               Arena<FIB>,
+               Arena<Choices>,
+               Arena<Packet>,
+               Arena<NodePacketHistory>,
+               Arena<PacketHistory>,
+               Arena<OpenflowUpdateState>,
+               Arena<ReachCounts>,
+               Arena<InjectionResult>,
+               Arena<InjectionResults>,
+               Arena<VisitedHops>>
+        arenas;
+
+    // Dense IDs of the stored objects referred to by the Spin state vector,
+    // assigned when the objects are stored
+    std::tuple<IDMap<Candidates>,
+               IDMap<FIB>,
+               IDMap<Choices>,
+               IDMap<PacketHistory>,
+               IDMap<OpenflowUpdateState>,
+               IDMap<ReachCounts>,
+               IDMap<InjectionResults>,
+               IDMap<VisitedHops>>
+        ids;
+
+    // Number of resets, after which the addresses of the objects may be reused
+    size_t generation = 0;
+
 public:
     // Disable the copy constructor and the copy assignment operator
     UniqueStorage(const UniqueStorage &) = delete;
@@ -53,17 +91,29 @@ public:
 
     static UniqueStorage &get();
 
-    Candidates *store_candidates(Candidates *);
-    FIB *store_fib(FIB *);
-    Choices *store_choices(Choices *);
-    Packet *store_packet(Packet *);
-    NodePacketHistory *store_node_pkt_hist(NodePacketHistory *);
-    PacketHistory *store_pkt_hist(PacketHistory *);
-    OpenflowUpdateState *store_of_update_state(OpenflowUpdateState *);
-    ReachCounts *store_reach_counts(ReachCounts *);
-    InjectionResult *store_injection_result(InjectionResult *);
-    InjectionResults *store_injection_results(InjectionResults *);
-    VisitedHops *store_visited_hops(VisitedHops *);
+    Candidates *store_candidates(Candidates &&);
+    FIB *store_fib(FIB &&);
+    Choices *store_choices(Choices &&);
+    Packet *store_packet(Packet &&);
+    NodePacketHistory *store_node_pkt_hist(NodePacketHistory &&);
+    PacketHistory *store_pkt_hist(PacketHistory &&);
+    OpenflowUpdateState *store_of_update_state(OpenflowUpdateState &&);
+    ReachCounts *store_reach_counts(ReachCounts &&);
+    InjectionResult *store_injection_result(InjectionResult &&);
+    InjectionResults *store_injection_results(InjectionResults &&);
+    VisitedHops *store_visited_hops(VisitedHops &&);
+
+    size_t get_generation() const { return generation; }
+
+    // Translation between stored objects and their IDs
+    template <class T>
+    uint32_t id(T *obj) {
+        return std::get<IDMap<T>>(ids).id(obj);
+    }
+    template <class T>
+    T *object(uint32_t id) const {
+        return std::get<IDMap<T>>(ids).object(id);
+    }
 };
 
 extern UniqueStorage &storage;
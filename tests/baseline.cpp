@@ -0,0 +1,133 @@
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "baseline.hpp"
+#include "configparser.hpp"
+#include "conn.hpp"
+#include "eqclassmgr.hpp"
+#include "fibmgr.hpp"
+#include "journal.hpp"
+#include "network.hpp"
+#include "plankton.hpp"
+#include "protocols.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+extern string test_data_dir;
+
+namespace {
+
+const fs::path baseline_dir = fs::temp_directory_path() / "neotests-baseline";
+
+// Returns the TCP connection from the node to the address
+vector<Connection> conn(const string &src_node, const char *dst_ip) {
+    return {Connection(proto::tcp,
+                       Plankton::get().network().nodes().at(src_node),
+                       EqClassMgr::get().find_ec(IPv4Address(dst_ip)), 1234,
+                       80)};
+}
+
+// Loads the baseline whose snapshot is that of the current network edited
+void load_baseline(Baseline &baseline,
+                   const function<void(vector<string> &)> &edit) {
+    const auto &plankton = Plankton::get();
+    Baseline::write_snapshot(baseline_dir, plankton.network(),
+                             plankton.openflow());
+
+    const fs::path path = baseline_dir / "dataplane";
+    vector<string> lines;
+    ifstream ifs(path);
+    for (string line; getline(ifs, line);) {
+        lines.push_back(line);
+    }
+    ifs.close();
+    edit(lines);
+    ofstream ofs(path);
+    for (const string &line : lines) {
+        ofs << line << endl;
+    }
+    ofs.close();
+
+    baseline.load(baseline_dir, plankton.network(), plankton.openflow());
+    REQUIRE(baseline.loaded());
+}
+
+} // namespace
+
+TEST_CASE("baseline") {
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    const string inputfn = test_data_dir + "/symmetry.toml";
+    REQUIRE_NOTHROW(ConfigParser().parse(inputfn, plankton));
+    auto &ec_mgr = EqClassMgr::get();
+    ec_mgr.compute_initial_ecs(plankton.network(), plankton.openflow());
+    FIBMgr::get().precompute(ec_mgr.all_ecs(), plankton.network(),
+                             plankton.openflow(), 1);
+    fs::remove_all(baseline_dir);
+    fs::create_directories(baseline_dir);
+    Baseline baseline;
+
+    SECTION("unchanged network") {
+        load_baseline(baseline, [](vector<string> &) {});
+        CHECK_FALSE(baseline.affected(conn("h1", "10.0.0.2")));
+        CHECK_FALSE(baseline.affected(conn("h4", "10.0.0.2")));
+    }
+
+    SECTION("topology change") {
+        load_baseline(baseline, [](vector<string> &lines) {
+            lines.push_back("T node ghost eth0 10.0.9.1/24");
+        });
+        CHECK(baseline.affected(conn("h1", "10.0.2.2")));
+        CHECK(baseline.affected(conn("h4", "10.0.0.2")));
+    }
+
+    SECTION("changed prefix") {
+        load_baseline(baseline, [](vector<string> &lines) {
+            lines.push_back("R r0 10.0.0.0/24 10.0.0.9 eth0 1");
+        });
+        CHECK(baseline.affected(conn("h1", "10.0.0.2")));     // destination
+        CHECK(baseline.affected(conn("server", "10.0.2.2"))); // source IP
+        CHECK_FALSE(baseline.affected(conn("h1", "10.0.2.2")));
+    }
+
+    SECTION("changed middlebox") {
+        load_baseline(baseline, [](vector<string> &lines) {
+            for (string &line : lines) {
+                if (line.starts_with("M mb ")) {
+                    line = "M mb 0";
+                }
+            }
+        });
+        CHECK(baseline.affected(conn("h4", "10.0.0.2")));
+        CHECK(baseline.affected(conn("h1", "10.0.5.2")));
+        CHECK_FALSE(baseline.affected(conn("h1", "10.0.0.2")));
+        CHECK_FALSE(baseline.affected(conn("h2", "10.0.1.2")));
+    }
+
+    SECTION("results matched by invariant and connections") {
+        {
+            Journal journal;
+            journal.open(baseline_dir, /* resume */ false);
+            journal.begin_invariant(1, 2, "inv");
+            journal.record(1, 0, {true, 1, 2, 3, 4, "conn a"});
+            journal.record(1, 1, {false, 1, 2, 3, 4, "conn b"});
+        }
+        load_baseline(baseline, [](vector<string> &) {});
+        const Journal::Result *res = baseline.result("inv", "conn a");
+        REQUIRE(res);
+        CHECK(res->violated);
+        REQUIRE(baseline.result("inv", "conn b"));
+        CHECK_FALSE(baseline.result("inv", "conn b")->violated);
+        CHECK_FALSE(baseline.result("inv", "conn c"));
+        CHECK_FALSE(baseline.result("other inv", "conn a"));
+    }
+
+    plankton.reset();
+    fs::remove_all(baseline_dir);
+}
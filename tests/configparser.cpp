@@ -0,0 +1,35 @@
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "configparser.hpp"
+#include "middlebox.hpp"
+#include "network.hpp"
+#include "plankton.hpp"
+
+using namespace std;
+
+extern string test_data_dir;
+
+// Returns the config digest of the middlebox fw in the given network
+static size_t fw_digest(const string &filename) {
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    REQUIRE_NOTHROW(ConfigParser().parse(test_data_dir + "/" + filename,
+                                         plankton));
+    Middlebox *mb =
+        static_cast<Middlebox *>(plankton.network().nodes().at("fw"));
+    REQUIRE(mb);
+    return mb->config_digest();
+}
+
+TEST_CASE("middlebox config digest") {
+    const size_t digest = fw_digest("docker.toml");
+    CHECK(digest != 0);
+    CHECK(fw_digest("docker.toml") == digest);
+
+    // Routes are installed into the container, so they change its behavior
+    CHECK(fw_digest("docker-route.toml") != digest);
+
+    Plankton::get().reset();
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "conn.hpp"
+#include "connmatrix.hpp"
+#include "eqclass.hpp"
+#include "node.hpp"
+#include "protocols.hpp"
+
+using namespace std;
+
+namespace {
+
+class TestNode : public Node {
+public:
+    TestNode(const string &n) { name = n; }
+};
+
+unique_ptr<EqClass> test_ec(const char *lb, const char *ub) {
+    auto ec = make_unique<EqClass>();
+    ec->add_range(ECRange(IPv4Address(lb), IPv4Address(ub)));
+    return ec;
+}
+
+} // namespace
+
+TEST_CASE("connmatrix") {
+    // Allocated against the order of the names and the addresses, so that the
+    // pointer order of the sets is unlikely to match the expected order
+    vector<unique_ptr<Node>> nodes;
+    for (const char *name : {"r2", "r1", "r0"}) {
+        nodes.push_back(make_unique<TestNode>(name));
+    }
+    vector<unique_ptr<EqClass>> ecs;
+    ecs.push_back(test_ec("10.0.2.0", "10.0.2.255"));
+    ecs.push_back(test_ec("10.0.1.0", "10.0.1.255"));
+
+    const set<Node *> src_nodes{nodes[0].get(), nodes[1].get(),
+                                nodes[2].get()};
+    const set<EqClass *> dst_ip_ecs{ecs[0].get(), ecs[1].get()};
+    const set<uint16_t> dst_ports{22, 80};
+
+    // Ordered by node name, then destination address, then port
+    vector<string> expected;
+    for (Node *node : {nodes[2].get(), nodes[1].get(), nodes[0].get()}) {
+        for (EqClass *ec : {ecs[1].get(), ecs[0].get()}) {
+            for (uint16_t port : dst_ports) {
+                expected.push_back(
+                    Connection(proto::tcp, node, ec, 1234, port).to_string());
+            }
+        }
+    }
+
+    SECTION("generated connections") {
+        ConnectionSet conns(proto::tcp, src_nodes, dst_ip_ecs, 1234, dst_ports);
+        REQUIRE(conns.size() == expected.size());
+        for (size_t i = 0; i < conns.size(); ++i) {
+            CHECK(conns.at(i).to_string() == expected[i]);
+        }
+    }
+
+    SECTION("explicit connections") {
+        set<Connection> explicit_conns;
+        for (Node *node : src_nodes) {
+            for (EqClass *ec : dst_ip_ecs) {
+                for (uint16_t port : dst_ports) {
+                    explicit_conns.emplace(proto::tcp, node, ec, 1234, port);
+                }
+            }
+        }
+        ConnectionSet conns(std::move(explicit_conns));
+        REQUIRE(conns.size() == expected.size());
+        for (size_t i = 0; i < conns.size(); ++i) {
+            CHECK(conns.at(i).to_string() == expected[i]);
+        }
+    }
+
+    SECTION("matrix indices") {
+        ConnectionMatrix matrix;
+        matrix.add(
+            ConnectionSet(proto::tcp, src_nodes, dst_ip_ecs, 1234, dst_ports));
+        matrix.add(ConnectionSet(proto::icmp_echo, {nodes[0].get()},
+                                 dst_ip_ecs, 0, {0}));
+        REQUIRE(matrix.size() == expected.size() * 2);
+
+        // The first connection set is the least significant digit
+        for (size_t i = 0; i < matrix.size(); ++i) {
+            const vector<Connection> conns = matrix.at(i);
+            REQUIRE(conns.size() == 2);
+            CHECK(conns[0].to_string() == expected[i % expected.size()]);
+            CHECK(conns[1].get_dst_ip_ec() ==
+                  (i < expected.size() ? ecs[1].get() : ecs[0].get()));
+        }
+
+        const auto combinations = matrix.range(5, 20);
+        REQUIRE(combinations.size() == 15);
+        for (size_t i = 0; i < combinations.size(); ++i) {
+            const vector<Connection> conns = matrix.at(5 + i);
+            CHECK(combinations[i][0].to_string() == conns[0].to_string());
+            CHECK(combinations[i][1].to_string() == conns[1].to_string());
+        }
+        CHECK(matrix.range(20, 100).size() == 4);
+    }
+}
+
+TEST_CASE("connmatrix sample") {
+    // Returns the digit of the index in the dimension
+    auto digit = [](size_t idx, const vector<size_t> &dim_sizes, size_t dim) {
+        for (size_t i = 0; i < dim; ++i) {
+            idx /= dim_sizes[i];
+        }
+        return idx % dim_sizes[dim];
+    };
+
+    SECTION("stratified sample") {
+        const vector<size_t> dim_sizes{10, 3};
+        const size_t n = 5;
+        const vector<size_t> sample = ConnectionMatrix::sample(dim_sizes, n, 1);
+
+        REQUIRE(sample.size() == n);
+        CHECK(is_sorted(sample.begin(), sample.end()));
+        CHECK(adjacent_find(sample.begin(), sample.end()) == sample.end());
+        CHECK(sample.back() < 30);
+        CHECK(ConnectionMatrix::sample(dim_sizes, n, 1) == sample);
+
+        // Every stratum of the larger dimension and every value of the smaller
+        // one are covered
+        set<size_t> strata, values;
+        for (size_t idx : sample) {
+            strata.insert(digit(idx, dim_sizes, 0) / 2);
+            values.insert(digit(idx, dim_sizes, 1));
+        }
+        CHECK(strata == set<size_t>{0, 1, 2, 3, 4});
+        CHECK(values == set<size_t>{0, 1, 2});
+    }
+
+    SECTION("sample of at least half of the combinations") {
+        const vector<size_t> dim_sizes{4, 3};
+        const vector<size_t> half = ConnectionMatrix::sample(dim_sizes, 6, 1);
+        REQUIRE(half.size() == 6);
+        CHECK(is_sorted(half.begin(), half.end()));
+        CHECK(adjacent_find(half.begin(), half.end()) == half.end());
+        CHECK(half.back() < 12);
+
+        vector<size_t> all(12);
+        iota(all.begin(), all.end(), 0);
+        CHECK(ConnectionMatrix::sample(dim_sizes, 12, 1) == all);
+        CHECK(ConnectionMatrix::sample(dim_sizes, 20, 1) == all);
+    }
+}
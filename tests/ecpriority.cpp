@@ -0,0 +1,72 @@
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "configparser.hpp"
+#include "conn.hpp"
+#include "ecpriority.hpp"
+#include "eqclassmgr.hpp"
+#include "fibmgr.hpp"
+#include "network.hpp"
+#include "plankton.hpp"
+#include "protocols.hpp"
+
+using namespace std;
+
+extern string test_data_dir;
+
+// Returns the TCP connection from the node to the address
+static Connection conn(const string &src_node, const char *dst_ip) {
+    return Connection(proto::tcp,
+                      Plankton::get().network().nodes().at(src_node),
+                      EqClassMgr::get().find_ec(IPv4Address(dst_ip)), 1234,
+                      80);
+}
+
+TEST_CASE("ecpriority") {
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    const string inputfn = test_data_dir + "/symmetry.toml";
+    REQUIRE_NOTHROW(ConfigParser().parse(inputfn, plankton));
+    auto &ec_mgr = EqClassMgr::get();
+    ec_mgr.compute_initial_ecs(plankton.network(), plankton.openflow());
+    FIBMgr::get().precompute(ec_mgr.all_ecs(), plankton.network(),
+                             plankton.openflow(), 1);
+
+    SECTION("paths") {
+        const auto direct = ECPriority::trace(conn("h1", "10.0.0.2"));
+        CHECK(direct.length == 2);
+        CHECK(direct.middleboxes == 0);
+        CHECK(direct.of_updates == 0);
+        CHECK(direct.branches == 0);
+
+        const auto via_mb = ECPriority::trace(conn("h4", "10.0.0.2"));
+        CHECK(via_mb.length == 3);
+        CHECK(via_mb.middleboxes == 1);
+    }
+
+    SECTION("score ordering") {
+        using Score = ECPriority::Score;
+        const Score direct = ECPriority::score({conn("h1", "10.0.0.2")}, false);
+        const Score via_mb = ECPriority::score({conn("h4", "10.0.0.2")}, false);
+        const Score violated =
+            ECPriority::score({conn("h1", "10.0.0.2")}, true);
+        CHECK(direct < via_mb);
+        CHECK(via_mb < violated);
+
+        // The concurrent connections add up
+        const Score both = ECPriority::score(
+            {conn("h4", "10.0.0.2"), conn("h4", "10.0.1.2")}, false);
+        CHECK(both.middleboxes == 2);
+        CHECK(via_mb < both);
+
+        // Each component outweighs all the less important ones
+        CHECK(Score{true, 0, 0, 0} > Score{false, 9, 9, 9});
+        CHECK(Score{false, 1, 0, 0} > Score{false, 0, 9, 9});
+        CHECK(Score{false, 0, 1, 0} > Score{false, 0, 0, 9});
+        CHECK(Score{false, 0, 0, 1} > Score{});
+    }
+
+    plankton.reset();
+}
@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "configparser.hpp"
+#include "injection-cache.hpp"
+#include "injection-result.hpp"
+#include "middlebox.hpp"
+#include "network.hpp"
+#include "packet.hpp"
+#include "pkt-hist.hpp"
+#include "plankton.hpp"
+#include "unique-storage.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+extern string test_data_dir;
+
+namespace {
+
+// Parses the network and returns the middlebox fw, with an empty shared tier
+Middlebox *load(const string &filename) {
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    REQUIRE_NOTHROW(ConfigParser().parse(test_data_dir + "/" + filename,
+                                         plankton));
+    injection_cache.init_shared(1024, 1 << 20);
+    Middlebox *mb =
+        static_cast<Middlebox *>(plankton.network().nodes().at("fw"));
+    REQUIRE(mb);
+    return mb;
+}
+
+Packet *packet(Middlebox *mb, const string &intf, uint16_t dst_port) {
+    return storage.store_packet(Packet(mb->get_intfs().at(intf),
+                                       IPv4Address("192.168.1.2"),
+                                       IPv4Address("192.168.2.2"), 1234,
+                                       dst_port, 0, 0, 0));
+}
+
+// History of a single packet sent to the given destination port
+NodePacketHistory *history(Middlebox *mb, uint16_t dst_port) {
+    return storage.store_node_pkt_hist(
+        NodePacketHistory(packet(mb, "eth0", dst_port), nullptr));
+}
+
+// Results of forwarding the packet of the history
+InjectionResults *results(Middlebox *mb, uint16_t dst_port) {
+    InjectionResults results;
+    results.add(storage.store_injection_result(
+        InjectionResult(list<Packet>{*packet(mb, "eth1", dst_port)}, false)));
+    return storage.store_injection_results(std::move(results));
+}
+
+// Returns the destination port of the cached results, or 0 if none is cached
+uint16_t cached_port(Middlebox *mb, uint16_t dst_port) {
+    InjectionResults *res = injection_cache.get(mb, history(mb, dst_port));
+    if (!res || res->size() != 1 || res->at(0).recv_pkts().size() != 1) {
+        return 0;
+    }
+    return res->at(0).recv_pkts()[0].get_dst_port();
+}
+
+} // namespace
+
+TEST_CASE("injection cache store") {
+    const fs::path cache_dir =
+        fs::temp_directory_path() / "neotests-injection-cache";
+    const fs::path store_path = cache_dir / "injection-cache.bin";
+    fs::remove_all(cache_dir);
+
+    // The records are appended in order, each only once
+    Middlebox *mb = load("docker.toml");
+    injection_cache.open_store(cache_dir);
+    for (uint16_t port : {1, 2, 3}) {
+        injection_cache.insert(mb, history(mb, port), results(mb, port));
+    }
+    const auto store_size = fs::file_size(store_path);
+    injection_cache.insert(mb, history(mb, 1), results(mb, 1));
+    REQUIRE(fs::file_size(store_path) == store_size);
+
+    SECTION("write and reopen") {
+        mb = load("docker.toml");
+        injection_cache.open_store(cache_dir);
+        CHECK(fs::file_size(store_path) == store_size);
+        for (uint16_t port : {1, 2, 3}) {
+            CHECK(cached_port(mb, port) == port);
+        }
+        CHECK(cached_port(mb, 4) == 0);
+    }
+
+    SECTION("truncated last record") {
+        mb = load("docker.toml");
+        fs::resize_file(store_path, store_size - 1);
+        injection_cache.open_store(cache_dir);
+        CHECK(fs::file_size(store_path) < store_size - 1);
+        CHECK(cached_port(mb, 1) == 1);
+        CHECK(cached_port(mb, 2) == 2);
+        CHECK(cached_port(mb, 3) == 0);
+
+        // New records follow the intact ones
+        injection_cache.insert(mb, history(mb, 3), results(mb, 3));
+        CHECK(fs::file_size(store_path) == store_size);
+    }
+
+    SECTION("changed middlebox config") {
+        mb = load("docker-route.toml");
+        injection_cache.open_store(cache_dir);
+        for (uint16_t port : {1, 2, 3}) {
+            CHECK(cached_port(mb, port) == 0);
+        }
+    }
+
+    Plankton::get().reset();
+    fs::remove_all(cache_dir);
+}
+
+TEST_CASE("injection cache across processes") {
+    Middlebox *mb = load("docker.toml");
+    CHECK(cached_port(mb, 1) == 0);
+
+    // Results learned by a forked EC process are visible to the others
+    pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        injection_cache.insert(mb, history(mb, 1), results(mb, 1));
+        _exit(0);
+    }
+
+    int status;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+    CHECK(cached_port(mb, 1) == 1);
+    CHECK(cached_port(mb, 2) == 0);
+
+    Plankton::get().reset();
+}
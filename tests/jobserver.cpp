@@ -0,0 +1,24 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "jobserver.hpp"
+
+TEST_CASE("jobserver") {
+    JobServer &jobserver = JobServer::get();
+
+    SECTION("uninitialized") {
+        jobserver.reset();
+        CHECK_FALSE(jobserver.try_acquire());
+        jobserver.release();
+    }
+
+    SECTION("tokens") {
+        jobserver.init(2);
+        CHECK(jobserver.try_acquire());
+        CHECK(jobserver.acquire());
+        CHECK_FALSE(jobserver.try_acquire());
+        jobserver.release();
+        CHECK(jobserver.acquire());
+        CHECK_FALSE(jobserver.try_acquire());
+        jobserver.reset();
+    }
+}
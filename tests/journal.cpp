@@ -0,0 +1,79 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "journal.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+TEST_CASE("journal") {
+    const fs::path out_dir = fs::temp_directory_path() / "neotests-journal";
+    const fs::path path = out_dir / "journal";
+    fs::remove_all(out_dir);
+    fs::create_directories(out_dir);
+
+    // A journal of a killed run, with a torn line at the end
+    ofstream ofs(path);
+    ofs << "I 1 3 inv one\n"
+           "E 1 0 1 10 20 30 40 conn a\n"
+           "E 1 1 0 10 20\n"
+           "garbage\n"
+           "E 1 2 0 10 20 30 40 conn c\n"
+           "E 2 0 1 10 20 30 40 conn x\n"
+           "I 3 2 inv three\n"
+           "E 3 0 1 1 2 3 4 conn p\n"
+           "I 3 2 inv three changed\n"
+           "E 3 1 0 1 2 3 4 conn q\n"
+           "E 1 1 0 1";
+    ofs.close();
+
+    SECTION("read") {
+        const auto invs = Journal::read(path);
+        REQUIRE(invs.size() == 2);
+        REQUIRE(invs.count(1) == 1);
+        REQUIRE(invs.count(3) == 1);
+
+        // Malformed and partial lines are skipped
+        const Journal::InvResults &inv1 = invs.at(1);
+        CHECK(inv1.num_ecs == 3);
+        CHECK(inv1.inv == "inv one");
+        REQUIRE(inv1.results.size() == 2);
+        const Journal::Result &res = inv1.results.at(0);
+        CHECK(res.violated);
+        CHECK(res.time == 10);
+        CHECK(res.peak_rss == 20);
+        CHECK(res.states_stored == 30);
+        CHECK(res.hash_conflicts == 40);
+        CHECK(res.conns == "conn a");
+        CHECK(inv1.results.at(2).conns == "conn c");
+
+        // A later start of the invariant discards its earlier results
+        const Journal::InvResults &inv3 = invs.at(3);
+        CHECK(inv3.inv == "inv three changed");
+        REQUIRE(inv3.results.size() == 1);
+        CHECK(inv3.results.at(1).conns == "conn q");
+    }
+
+    SECTION("resume") {
+        Journal journal;
+        journal.open(out_dir, /* resume */ true);
+
+        journal.begin_invariant(1, 3, "inv one");
+        CHECK(journal.num_finished(1) == 2);
+        CHECK(journal.violated(1));
+        CHECK(journal.discard_mismatched(1, [](size_t i) {
+            return i == 0 ? "conn a" : "conn z";
+        }) == 1);
+        CHECK(journal.finished(1, 0));
+        CHECK_FALSE(journal.finished(1, 2));
+
+        // A changed invariant discards its results
+        journal.begin_invariant(3, 2, "inv three changed again");
+        CHECK(journal.num_finished(3) == 0);
+    }
+
+    fs::remove_all(out_dir);
+}
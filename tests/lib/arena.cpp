@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/arena.hpp"
+
+using namespace std;
+
+namespace {
+
+struct Counted {
+    static inline int alive = 0;
+    string str;
+
+    Counted(string &&s) : str(std::move(s)) { ++alive; }
+    ~Counted() { --alive; }
+};
+
+} // namespace
+
+TEST_CASE("arena") {
+    Arena<Counted, 4> arena;
+
+    SECTION("objects across slabs") {
+        vector<Counted *> objs;
+        for (int i = 0; i < 10; ++i) {
+            objs.push_back(arena.create(to_string(i)));
+        }
+        CHECK(arena.size() == 10);
+        CHECK(Counted::alive == 10);
+        for (int i = 0; i < 10; ++i) {
+            CHECK(objs[i]->str == to_string(i));
+        }
+    }
+
+    SECTION("reset") {
+        for (int i = 0; i < 10; ++i) {
+            arena.create(to_string(i));
+        }
+        arena.reset();
+        CHECK(arena.size() == 0);
+        CHECK(Counted::alive == 0);
+
+        Counted *obj = arena.create("reused");
+        CHECK(arena.size() == 1);
+        CHECK(obj->str == "reused");
+    }
+
+    arena.reset();
+    CHECK(Counted::alive == 0);
+}
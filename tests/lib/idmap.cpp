@@ -0,0 +1,66 @@
+#include <atomic>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/idmap.hpp"
+
+namespace {
+
+struct Object : public DenseID {
+    int value = 0;
+};
+
+} // namespace
+
+TEST_CASE("idmap") {
+    IDMap<Object> ids;
+    Object a, b;
+
+    CHECK(ids.id(nullptr) == 0);
+    CHECK(ids.object(0) == nullptr);
+
+    SECTION("assigned on first sight") {
+        const uint32_t id_a = ids.id(&a);
+        const uint32_t id_b = ids.id(&b);
+        CHECK(id_a == 1);
+        CHECK(id_b == 2);
+        CHECK(ids.id(&a) == id_a);
+        CHECK(ids.object(id_a) == &a);
+        CHECK(ids.object(id_b) == &b);
+        CHECK(ids.size() == 2);
+    }
+
+    SECTION("copies are different objects") {
+        CHECK(ids.assign(&a) == 1);
+        Object c(a);
+        CHECK(ids.id(&c) == 2);
+        c = a;
+        CHECK(ids.id(&c) == 2);
+        CHECK(ids.object(1) == &a);
+    }
+
+    SECTION("objects outliving clear") {
+        ids.id(&a);
+        ids.id(&b);
+        ids.clear();
+        CHECK(ids.size() == 0);
+        CHECK(ids.id(&b) == 1);
+        CHECK(ids.id(&a) == 2);
+        CHECK(ids.object(1) == &b);
+    }
+
+    SECTION("shared counter") {
+        std::atomic<uint32_t> next;
+        Object c;
+        CHECK(ids.id(&a) == 1);
+        ids.share(&next);
+        IDMap<Object> forked(ids);
+        CHECK(ids.id(&b) == 2);
+        CHECK(forked.id(&a) == 1);
+        CHECK(forked.id(&c) == 3);
+        CHECK(forked.object(2) == nullptr);
+        CHECK(forked.object(3) == &c);
+        CHECK(ids.size() == 2);
+        CHECK(forked.size() == 3);
+    }
+}
@@ -0,0 +1,193 @@
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "fib.hpp"
+#include "lib/arena.hpp"
+#include "lib/intern-table.hpp"
+#include "node.hpp"
+
+using namespace std;
+
+namespace {
+
+class TestNode : public Node {
+public:
+    TestNode(size_t i) { idx = i; }
+};
+
+Node *test_node(size_t i) {
+    static vector<unique_ptr<TestNode>> nodes;
+    while (nodes.size() < 64) {
+        nodes.push_back(make_unique<TestNode>(nodes.size()));
+    }
+    return nodes[i % 64].get();
+}
+
+// Returns n FIBs over 32 nodes, of which about half are duplicates
+vector<unique_ptr<FIB>> random_fibs(size_t n) {
+    mt19937 rng(0);
+    vector<unique_ptr<FIB>> fibs;
+    for (size_t i = 0; i < n; ++i) {
+        auto fib = make_unique<FIB>();
+        const size_t variant = rng() % (n / 2);
+        for (size_t j = 0; j < 32; ++j) {
+            Node *nh = test_node((variant + j) % 64);
+            set<FIB_IPNH> next_hops;
+            next_hops.emplace(nh, nullptr, nh, nullptr);
+            fib->set_ipnhs(test_node(j), std::move(next_hops));
+        }
+        fibs.push_back(std::move(fib));
+    }
+    return fibs;
+}
+
+} // namespace
+
+TEST_CASE("intern-table") {
+    InternTable<FIB, FIBHash, FIBEq> table;
+    auto fibs = random_fibs(1000);
+    unordered_set<FIB *, FIBHash, FIBEq> expected;
+
+    for (const auto &fib : fibs) {
+        const size_t hash = table.hash(fib.get());
+        FIB *stored = table.find(fib.get(), hash);
+        auto res = expected.insert(fib.get());
+        CHECK(bool(stored) != res.second);
+        if (stored) {
+            CHECK(stored == *res.first);
+        } else {
+            table.insert(fib.get(), hash);
+        }
+    }
+    CHECK(table.size() == expected.size());
+
+    table.clear();
+    CHECK(table.size() == 0);
+    CHECK_FALSE(table.find(fibs[0].get(), table.hash(fibs[0].get())));
+}
+
+TEST_CASE("cached hashes") {
+    Node *n0 = test_node(0), *n1 = test_node(1);
+    FIB a, b;
+
+    // Same entries set in different orders and with overwrites
+    a.set_ipnhs(n0, {FIB_IPNH(n1, nullptr, n1, nullptr)});
+    a.set_ipnhs(n1, {FIB_IPNH(n0, nullptr, n0, nullptr)});
+    b.add_ipnh(n1, FIB_IPNH(n1, nullptr, n1, nullptr));
+    b.set_ipnhs(n0, {FIB_IPNH(n1, nullptr, n1, nullptr)});
+    CHECK_FALSE(FIBEq()(&a, &b));
+    b.set_ipnhs(n1, {FIB_IPNH(n0, nullptr, n0, nullptr)});
+    CHECK(FIBHash()(&a) == FIBHash()(&b));
+    CHECK(FIBEq()(&a, &b));
+}
+
+TEST_CASE("fib lookup") {
+    Node *n0 = test_node(0), *n1 = test_node(1), *n2 = test_node(2);
+    FIB a, b;
+
+    a.set_ipnhs(n1, {FIB_IPNH(n0, nullptr, n0, nullptr)});
+    CHECK(a.lookup(n1).size() == 1);
+    CHECK_THROWS_AS(a.lookup(n0), out_of_range);
+    CHECK_THROWS_AS(a.lookup(n2), out_of_range);
+
+    // A node set without next hops is not the same as one that is not set
+    b.set_ipnhs(n1, {FIB_IPNH(n0, nullptr, n0, nullptr)});
+    CHECK(FIBEq()(&a, &b));
+    b.set_ipnhs(n2, set<FIB_IPNH>());
+    CHECK(b.lookup(n2).empty());
+    CHECK_FALSE(FIBEq()(&a, &b));
+}
+
+// Run with: neotests "[benchmark]"
+TEST_CASE("intern-table-benchmark", "[.benchmark]") {
+    auto fibs = random_fibs(20000);
+
+    // The intern sets of UniqueStorage before the flat tables
+    BENCHMARK("unordered_set") {
+        unordered_set<FIB *, FIBHash, FIBEq> store;
+        for (const auto &fib : fibs) {
+            store.insert(fib.get());
+        }
+        return store.size();
+    };
+
+    BENCHMARK("intern table") {
+        InternTable<FIB, FIBHash, FIBEq> store;
+        for (const auto &fib : fibs) {
+            const size_t hash = store.hash(fib.get());
+            if (!store.find(fib.get(), hash)) {
+                store.insert(fib.get(), hash);
+            }
+        }
+        return store.size();
+    };
+}
+
+// Run with: neotests "[benchmark]"
+TEST_CASE("storage-benchmark", "[.benchmark]") {
+    auto fibs = random_fibs(20000);
+
+    // Storing the FIBs of an EC and resetting the storage for the next one, as
+    // UniqueStorage did before the arenas: every candidate is allocated, the
+    // duplicates are deleted right away, and the rest are deleted by the reset
+    BENCHMARK("unordered_set with new/delete") {
+        unordered_set<FIB *, FIBHash, FIBEq> store;
+        for (const auto &fib : fibs) {
+            FIB *candidate = new FIB(*fib);
+            auto res = store.insert(candidate);
+            if (!res.second) {
+                delete candidate;
+            }
+        }
+        const size_t size = store.size();
+        for (FIB *fib : store) {
+            delete fib;
+        }
+        store.clear();
+        return size;
+    };
+
+    // Candidates are built on the stack and only moved to the heap if new,
+    // which separates the cost of the arena from that of the duplicates
+    InternTable<FIB, FIBHash, FIBEq> store;
+    BENCHMARK("intern table with new/delete") {
+        vector<FIB *> stored;
+        for (const auto &fib : fibs) {
+            FIB candidate(*fib);
+            const size_t hash = store.hash(&candidate);
+            if (!store.find(&candidate, hash)) {
+                stored.push_back(new FIB(std::move(candidate)));
+                store.insert(stored.back(), hash);
+            }
+        }
+        const size_t size = store.size();
+        store.clear();
+        for (FIB *fib : stored) {
+            delete fib;
+        }
+        return size;
+    };
+
+    // The arena is kept across ECs like those of UniqueStorage
+    Arena<FIB> arena;
+    BENCHMARK("intern table with arena") {
+        for (const auto &fib : fibs) {
+            FIB candidate(*fib);
+            const size_t hash = store.hash(&candidate);
+            if (!store.find(&candidate, hash)) {
+                store.insert(arena.create(std::move(candidate)), hash);
+            }
+        }
+        const size_t size = store.size();
+        store.clear();
+        arena.reset();
+        return size;
+    };
+}
@@ -0,0 +1,148 @@
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/ip.hpp"
+#include "lib/lpm-trie.hpp"
+#include "route.hpp"
+#include "routingtable.hpp"
+
+using namespace std;
+
+TEST_CASE("lpm-trie") {
+    LPMTrie trie;
+
+    SECTION("empty trie") {
+        CHECK(trie.empty());
+        CHECK_FALSE(trie.lookup("10.0.0.1"));
+        CHECK_NOTHROW(trie.erase("10.0.0.0/8"));
+        CHECK(trie.size() == 0);
+    }
+
+    SECTION("longest prefix match") {
+        trie.insert("10.0.0.0/8");
+        trie.insert("10.1.0.0/16");
+        trie.insert("10.1.2.0/24");
+        trie.insert("10.1.2.3/32");
+        trie.insert("192.168.0.0/16");
+        trie.insert("10.1.0.0/16"); // duplicate
+        CHECK(trie.size() == 5);
+
+        CHECK(*trie.lookup("10.1.2.3") == "10.1.2.3/32");
+        CHECK(*trie.lookup("10.1.2.4") == "10.1.2.0/24");
+        CHECK(*trie.lookup("10.1.3.4") == "10.1.0.0/16");
+        CHECK(*trie.lookup("10.2.3.4") == "10.0.0.0/8");
+        CHECK(*trie.lookup("192.168.255.255") == "192.168.0.0/16");
+        CHECK_FALSE(trie.lookup("11.0.0.1"));
+        CHECK_FALSE(trie.lookup("192.169.0.1"));
+
+        trie.insert("0.0.0.0/0");
+        CHECK(*trie.lookup("11.0.0.1") == "0.0.0.0/0");
+    }
+
+    SECTION("erase and clear") {
+        trie.insert("10.0.0.0/8");
+        trie.insert("10.1.0.0/16");
+        trie.insert("10.1.2.0/24");
+
+        trie.erase("10.1.0.0/16");
+        CHECK(trie.size() == 2);
+        CHECK(*trie.lookup("10.1.2.1") == "10.1.2.0/24");
+        CHECK(*trie.lookup("10.1.3.1") == "10.0.0.0/8");
+        trie.erase("10.1.0.0/16"); // absent
+        trie.erase("10.1.0.0/17"); // never inserted
+        CHECK(trie.size() == 2);
+
+        trie.insert("10.1.0.0/16");
+        CHECK(*trie.lookup("10.1.3.1") == "10.1.0.0/16");
+
+        trie.clear();
+        CHECK(trie.empty());
+        CHECK_FALSE(trie.lookup("10.1.2.1"));
+    }
+
+    SECTION("consistency with linear scan") {
+        mt19937 rng(0);
+        RoutingTable rib;
+        vector<IPNetwork<IPv4Address>> nets;
+
+        for (int i = 0; i < 500; ++i) {
+            int len = rng() % 33;
+            uint32_t mask = len == 0 ? 0 : ~uint32_t(0) << (32 - len);
+            IPNetwork<IPv4Address> net(IPv4Address((rng() & 0x0fffffff) & mask),
+                                       len);
+            trie.insert(net);
+            rib.insert(Route(net));
+            nets.push_back(net);
+        }
+        for (int i = 0; i < 100; ++i) {
+            trie.erase(nets[i]);
+            rib.erase(Route(nets[i]));
+        }
+        CHECK(trie.size() == rib.size());
+
+        for (int i = 0; i < 5000; ++i) {
+            IPv4Address addr(rng() & 0x0fffffff);
+            auto res = trie.lookup(addr);
+            const Route *expected = nullptr;
+            for (const Route &route : rib) {
+                if (route.get_network().contains(addr)) {
+                    expected = &route;
+                    break;
+                }
+            }
+            if (expected) {
+                REQUIRE(res);
+                CHECK(*res == expected->get_network());
+            } else {
+                CHECK_FALSE(res);
+            }
+
+            auto range = rib.lookup(addr);
+            CHECK((range.first != range.second) == bool(expected));
+        }
+    }
+}
+
+// Run with: neotests "[benchmark]"
+TEST_CASE("lpm-trie-benchmark", "[.benchmark]") {
+    mt19937 rng(0);
+    RoutingTable rib;
+    for (int i = 0; i < 5000; ++i) {
+        int len = 8 + rng() % 25;
+        uint32_t mask = ~uint32_t(0) << (32 - len);
+        rib.insert(Route(IPNetwork<IPv4Address>(IPv4Address(rng() & mask), len),
+                         IPv4Address("1.2.3.4")));
+    }
+
+    vector<IPv4Address> addrs;
+    for (int i = 0; i < 1000; ++i) {
+        addrs.emplace_back(uint32_t(rng()));
+    }
+
+    BENCHMARK("linear scan") {
+        size_t found = 0;
+        for (const IPv4Address &addr : addrs) {
+            for (const Route &route : rib) {
+                if (route.get_network().contains(addr)) {
+                    found += rib.lookup(route.get_network()).first != rib.end();
+                    break;
+                }
+            }
+        }
+        return found;
+    };
+
+    BENCHMARK("lpm trie") {
+        size_t found = 0;
+        for (const IPv4Address &addr : addrs) {
+            auto range = rib.lookup(addr);
+            found += range.first != range.second;
+        }
+        return found;
+    };
+}
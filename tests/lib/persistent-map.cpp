@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/persistent-map.hpp"
+
+using namespace std;
+
+namespace {
+
+// Forces full-hash collisions
+struct CollidingHash {
+    size_t operator()(int key) const { return key % 7; }
+};
+
+template <class Hash>
+void check_against_std_map() {
+    mt19937 rng(0);
+
+    for (int round = 0; round < 100; ++round) {
+        PersistentMap<int, int, Hash> map;
+        std::map<int, int> expected;
+        vector<pair<PersistentMap<int, int, Hash>, std::map<int, int>>>
+            versions;
+
+        for (int i = 0; i < 200; ++i) {
+            const int key = rng() % 100, value = rng() % 5;
+            versions.emplace_back(map, expected);
+            CHECK(map.assign(key, value) == !expected.count(key));
+            expected[key] = value;
+        }
+        REQUIRE(map.size() == expected.size());
+
+        // Older versions are unaffected by later assignments
+        for (const auto &[old_map, old_expected] : versions) {
+            CHECK(old_map.size() == old_expected.size());
+            for (int key = 0; key < 100; ++key) {
+                const int *value = old_map.find(key);
+                REQUIRE(bool(value) == bool(old_expected.count(key)));
+                if (value) {
+                    CHECK(*value == old_expected.at(key));
+                }
+            }
+        }
+
+        size_t count = 0;
+        map.for_each([&](int key, int value) {
+            CHECK(expected.at(key) == value);
+            ++count;
+        });
+        CHECK(count == expected.size());
+
+        // Same entries assigned in another order
+        vector<pair<int, int>> entries(expected.begin(), expected.end());
+        shuffle(entries.begin(), entries.end(), rng);
+        PersistentMap<int, int, Hash> other;
+        for (const auto &[key, value] : entries) {
+            other.assign(key, value);
+        }
+        CHECK(map == other);
+
+        other.assign(entries[0].first, entries[0].second + 1);
+        CHECK_FALSE(map == other);
+        CHECK(*map.find(entries[0].first) == entries[0].second);
+    }
+}
+
+} // namespace
+
+TEST_CASE("persistent-map") {
+    SECTION("distinct hashes") {
+        check_against_std_map<std::hash<int>>();
+    }
+
+    SECTION("colliding hashes") {
+        check_against_std_map<CollidingHash>();
+    }
+
+    SECTION("empty maps") {
+        PersistentMap<int, int> a, b;
+        CHECK(a.size() == 0);
+        CHECK_FALSE(a.find(0));
+        CHECK(a == b);
+        b.assign(0, 0);
+        CHECK_FALSE(a == b);
+    }
+}
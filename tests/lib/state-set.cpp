@@ -0,0 +1,127 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/state-set.hpp"
+
+using namespace std;
+
+TEST_CASE("state-set") {
+    StateSet set;
+    uint32_t state[4] = {1, 2, 3, 4};
+
+    SECTION("exact states") {
+        set.init(16, sizeof(state), /* compact */ false);
+        CHECK(set.insert(state));
+        CHECK_FALSE(set.insert(state));
+        state[3] = 5;
+        CHECK(set.insert(state));
+        CHECK(set.size() == 2);
+    }
+
+    SECTION("fingerprints") {
+        set.init(16, sizeof(state), /* compact */ true);
+        CHECK(set.insert(state));
+        CHECK_FALSE(set.insert(state));
+        state[0] = 0;
+        CHECK(set.insert(state));
+        CHECK(set.size() == 2);
+    }
+
+    SECTION("full table") {
+        set.init(4, sizeof(state), /* compact */ false);
+        for (uint32_t i = 0; i < 4; ++i) {
+            state[0] = i;
+            CHECK(set.insert(state));
+        }
+        CHECK(set.size() == 4);
+        state[0] = 4;
+        CHECK_THROWS(set.insert(state));
+    }
+
+    SECTION("shared with forked processes") {
+        set.init(16, sizeof(state), /* compact */ false);
+        CHECK(set.insert(state));
+
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            const bool dup = !set.insert(state);
+            state[3] = 5;
+            _exit(dup && set.insert(state) ? 0 : 1);
+        }
+        int status;
+        REQUIRE(waitpid(pid, &status, 0) == pid);
+        CHECK(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 0);
+
+        CHECK_FALSE(set.insert(state));
+        state[3] = 5;
+        CHECK_FALSE(set.insert(state));
+        CHECK(set.size() == 2);
+    }
+
+    SECTION("cleared for reuse") {
+        set.init(16, sizeof(state), /* compact */ false);
+        CHECK(set.insert(state));
+        set.init(16, sizeof(state), /* compact */ false);
+        CHECK(set.size() == 0);
+        CHECK(set.insert(state));
+    }
+
+    SECTION("sized from the memory budget") {
+        CHECK(StateSet::num_slots(1 << 20, 16, /* compact */ true) ==
+              (1 << 17));
+        CHECK(StateSet::num_slots(1 << 20, 16, /* compact */ false) ==
+              (1 << 15));
+        CHECK(StateSet::num_slots(0, 16, /* compact */ false) == (1 << 10));
+    }
+}
+
+// Run with: neotests "[benchmark]"
+TEST_CASE("state-set-benchmark", "[.benchmark]") {
+    // Random state vectors with many duplicates, like the revisits of a DFS
+    const size_t state_size = 256;
+    mt19937 rng(0);
+    vector<string> states(50000, string(state_size, '\0'));
+    for (string &state : states) {
+        state[rng() % 8] = rng() % 64;
+        state[state_size - 1 - rng() % 8] = rng() % 64;
+    }
+
+    // A node-based hash set of the state vectors
+    BENCHMARK("unordered_set") {
+        unordered_set<string> visited;
+        for (const string &state : states) {
+            visited.insert(state);
+        }
+        return visited.size();
+    };
+
+    BENCHMARK("state set") {
+        StateSet visited;
+        visited.init(StateSet::num_slots(64 << 20, state_size, false),
+                     state_size, /* compact */ false);
+        for (const string &state : states) {
+            visited.insert(state.data());
+        }
+        return visited.size();
+    };
+
+    BENCHMARK("state set (compact)") {
+        StateSet visited;
+        visited.init(StateSet::num_slots(64 << 20, state_size, true),
+                     state_size, /* compact */ true);
+        for (const string &state : states) {
+            visited.insert(state.data());
+        }
+        return visited.size();
+    };
+}
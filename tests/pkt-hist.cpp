@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "packet.hpp"
+#include "pkt-hist.hpp"
+
+using namespace std;
+
+TEST_CASE("node-pkt-hist") {
+    vector<Packet> pkts(3);
+    vector<unique_ptr<NodePacketHistory>> storage;
+    map<pair<Packet *, NodePacketHistory *>, NodePacketHistory *> interned;
+    vector<NodePacketHistory *> hists{nullptr};
+    mt19937 rng(0);
+
+    // A random tree of interned histories, growing mostly from recent ones
+    for (int i = 0; i < 2000; ++i) {
+        NodePacketHistory *past = hists[hists.size() - 1 - rng() % min<size_t>(
+                                                               hists.size(), 8)];
+        Packet *pkt = &pkts[rng() % pkts.size()];
+        auto &nph = interned[{pkt, past}];
+        if (!nph) {
+            storage.push_back(make_unique<NodePacketHistory>(pkt, past));
+            nph = storage.back().get();
+            hists.push_back(nph);
+        }
+    }
+
+    auto packets_of = [](NodePacketHistory *nph) {
+        return nph ? nph->get_packets() : list<Packet *>();
+    };
+
+    for (int i = 0; i < 5000; ++i) {
+        NodePacketHistory *a = hists[rng() % hists.size()];
+        NodePacketHistory *b = hists[rng() % hists.size()];
+        const list<Packet *> a_pkts = packets_of(a), b_pkts = packets_of(b);
+
+        if (a) {
+            const bool is_prefix =
+                b_pkts.size() <= a_pkts.size() &&
+                equal(b_pkts.begin(), b_pkts.end(), a_pkts.begin());
+            CHECK(a->contains(b) == is_prefix);
+            if (is_prefix) {
+                list<Packet *> since = a->get_packets_since(b);
+                CHECK(since.size() == a_pkts.size() - b_pkts.size());
+                CHECK(equal(since.begin(), since.end(),
+                            next(a_pkts.begin(), b_pkts.size())));
+            }
+        }
+
+        CHECK(NodePacketHistoryComp()(a, b) ==
+              lexicographical_compare(a_pkts.begin(), a_pkts.end(),
+                                      b_pkts.begin(), b_pkts.end()));
+    }
+}
@@ -0,0 +1,109 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "journal.hpp"
+#include "plankton.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+extern string test_data_dir;
+
+// Returns the violation results of the ECs of each invariant, in order
+static vector<vector<bool>> verify(const string &filename,
+                                   PlanktonOptions opts) {
+    const fs::path out_dir = fs::temp_directory_path() / "neotests-plankton";
+    fs::remove_all(out_dir);
+
+    opts.all_ecs = true;
+    opts.max_jobs = 2;
+    opts.input_file = test_data_dir + "/" + filename;
+    opts.output_dir = out_dir;
+
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    REQUIRE_NOTHROW(plankton.init(opts));
+    REQUIRE(plankton.run() == 0);
+    plankton.reset();
+
+    vector<vector<bool>> results;
+    for (const auto &[inv_id, inv] : Journal::read(out_dir / "journal")) {
+        vector<bool> &inv_results = results.emplace_back(inv.num_ecs);
+        for (const auto &[ec_idx, res] : inv.results) {
+            inv_results.at(ec_idx) = res.violated;
+        }
+        CHECK(inv.results.size() == inv.num_ecs);
+    }
+    fs::remove_all(out_dir);
+    return results;
+}
+
+// Returns the options of the given exploration engine
+static PlanktonOptions engine(const string &name) {
+    PlanktonOptions opts;
+    opts.engine = name;
+    return opts;
+}
+
+TEST_CASE("explorer") {
+    const auto spin = verify("model.toml", engine("spin"));
+    const auto native = verify("model.toml", engine("native"));
+
+    REQUIRE(spin.size() == 3);
+    CHECK(spin == native);
+    for (bool violated : native[0]) {
+        CHECK_FALSE(violated);
+    }
+    CHECK(native[1].at(0));
+    for (bool violated : native[2]) {
+        CHECK_FALSE(violated);
+    }
+}
+
+TEST_CASE("partial-order reduction") {
+    PlanktonOptions opts;
+    const auto full = verify("docker-por.toml", opts);
+    opts.por = true;
+    const auto reduced = verify("docker-por.toml", opts);
+
+    REQUIRE(full.size() == 2);
+    CHECK(full == reduced);
+    CHECK_FALSE(reduced[0].at(0));
+    CHECK(reduced[1].at(0));
+}
+
+TEST_CASE("violation rate bound") {
+    // Every EC is sampled, so the rate is exact
+    CHECK(Plankton::violation_rate_bound(0, 10, 10) == 0);
+    CHECK(Plankton::violation_rate_bound(3, 10, 10) == Catch::Approx(0.3));
+
+    // Wilson score interval without violations: z^2 / (n + z^2)
+    const double z2 = 1.96 * 1.96;
+    const double bound = Plankton::violation_rate_bound(0, 100, 1000000000);
+    CHECK(bound == Catch::Approx(z2 / (100 + z2)).epsilon(1e-6));
+
+    // The finite population correction tightens the bound
+    CHECK(Plankton::violation_rate_bound(0, 100, 200) < bound);
+    CHECK(Plankton::violation_rate_bound(5, 100, 1000) >
+          Plankton::violation_rate_bound(0, 100, 1000));
+    CHECK(Plankton::violation_rate_bound(5, 100, 1000) > 0.05);
+    CHECK(Plankton::violation_rate_bound(100, 100, 1000) == Catch::Approx(1));
+}
+
+// Run with: neotests "[benchmark]"
+TEST_CASE("explorer-benchmark", "[.benchmark]") {
+    // The bundled examples need Docker middleboxes, so only the model-only
+    // test network is measured here.
+    BENCHMARK("spin") {
+        return verify("model.toml", engine("spin"));
+    };
+
+    BENCHMARK("native") {
+        return verify("model.toml", engine("native"));
+    };
+}
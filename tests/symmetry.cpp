@@ -0,0 +1,75 @@
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "configparser.hpp"
+#include "conn.hpp"
+#include "connmatrix.hpp"
+#include "eqclassmgr.hpp"
+#include "fibmgr.hpp"
+#include "network.hpp"
+#include "node.hpp"
+#include "plankton.hpp"
+#include "protocols.hpp"
+#include "symmetry.hpp"
+
+using namespace std;
+
+extern string test_data_dir;
+
+TEST_CASE("symmetry") {
+    auto &plankton = Plankton::get();
+    plankton.reset();
+    const string inputfn = test_data_dir + "/symmetry.toml";
+    REQUIRE_NOTHROW(ConfigParser().parse(inputfn, plankton));
+    const auto &network = plankton.network();
+    auto &ec_mgr = EqClassMgr::get();
+    ec_mgr.compute_initial_ecs(network, plankton.openflow());
+    FIBMgr::get().precompute(ec_mgr.all_ecs(), network, plankton.openflow(), 1);
+
+    EqClass *dst_ip_ec = ec_mgr.find_ec(IPv4Address("10.0.0.2"));
+    REQUIRE(dst_ip_ec);
+    set<Connection> conns;
+    for (const char *name : {"h1", "h2", "h3", "h4"}) {
+        conns.emplace(proto::tcp, network.nodes().at(name), dst_ip_ec, 1234,
+                      80);
+    }
+
+    // Returns the source nodes of each group, ordered by the representatives
+    auto groups = [&](const unordered_set<Node *> &distinguished) {
+        const ConnectionSet conn_set(Symmetry(distinguished).reduce(conns));
+        vector<vector<string>> src_nodes;
+        for (size_t i = 0; i < conn_set.size(); ++i) {
+            const vector<Connection> members = conn_set.members(i);
+            REQUIRE_FALSE(members.empty());
+            CHECK(members[0].to_string() == conn_set.at(i).to_string());
+            vector<string> &names = src_nodes.emplace_back();
+            for (const Connection &conn : members) {
+                names.push_back(conn.get_src_node()->get_name());
+            }
+        }
+        return src_nodes;
+    };
+
+    SECTION("isomorphic sources") {
+        const vector<vector<string>> expected{{"h1", "h2", "h3"}, {"h4"}};
+        CHECK(groups({}) == expected);
+    }
+
+    SECTION("distinguished sources") {
+        const vector<vector<string>> expected{{"h1", "h3"}, {"h2"}, {"h4"}};
+        CHECK(groups({network.nodes().at("h2")}) == expected);
+    }
+
+    SECTION("generated connections represent themselves") {
+        const ConnectionSet conn_set(proto::tcp, {network.nodes().at("h1")},
+                                     {dst_ip_ec}, 1234, {80});
+        REQUIRE(conn_set.members(0).size() == 1);
+        CHECK(conn_set.members(0)[0].to_string() == conn_set.at(0).to_string());
+    }
+
+    plankton.reset();
+}